@@ -0,0 +1,51 @@
+#pragma once
+#include <stddef.h>
+#include <string.h>
+#include <string_view>
+
+/*
+    An immutable name stored inside the object that owns it
+    Names up to INLINE_CAPACITY characters (every name in a typical trace) need no allocation,
+    longer ones fall back to the heap.
+    Reads as a std::string_view anywhere one is expected.
+*/
+class InlineName
+{
+public:
+    static const size_t INLINE_CAPACITY = 24;
+
+    explicit InlineName(std::string_view text) : length(text.size())
+    {
+        char* dest = inlineText;
+        if (length > INLINE_CAPACITY)
+        {
+            heapText = new char[length];
+            dest = heapText;
+        }
+        memcpy(dest, text.data(), length);
+    }
+    InlineName(const InlineName&) = delete;
+    InlineName& operator=(const InlineName&) = delete;
+    ~InlineName()
+    {
+        if (length > INLINE_CAPACITY)
+        {
+            delete[] heapText;
+        }
+    }
+
+    const char* data() const { return (length > INLINE_CAPACITY) ? heapText : inlineText; }
+    size_t size() const { return length; }
+    std::string_view View() const { return std::string_view(data(), length); }
+    operator std::string_view() const { return View(); }
+
+    bool operator<(const InlineName& other) const { return View() < other.View(); }
+
+private:
+    union
+    {
+        char inlineText[INLINE_CAPACITY];
+        char* heapText;
+    };
+    size_t length;
+};
@@ -0,0 +1,183 @@
+#pragma once
+#include <stddef.h>
+
+/*
+    Doubly linked list whose links live inside the items themselves
+
+    An item embeds one ListLinks per list it can be on, and the list is told which one to use:
+        struct Job { ListLinks<Job> queueLinks; ... };
+        IntrusiveList<Job, &Job::queueLinks> queue;
+    Nothing is allocated, and pushing, removing (given the item) and splicing whole lists are all O(1).
+    An item can only be on one list per ListLinks at a time, and the list never owns its items.
+*/
+template <typename T>
+struct ListLinks
+{
+    T* prev = nullptr;
+    T* next = nullptr;
+};
+
+template <typename T, ListLinks<T> T::*LINKS>
+class IntrusiveList
+{
+public:
+    IntrusiveList() : head(nullptr), tail(nullptr), count(0) {}
+    IntrusiveList(const IntrusiveList&) = delete;
+    IntrusiveList& operator=(const IntrusiveList&) = delete;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T* Front() const { return head; }
+    T* Back() const { return tail; }
+    static T* Next(const T* item) { return (item->*LINKS).next; }
+
+    void PushBack(T* item)
+    {
+        (item->*LINKS).prev = tail;
+        (item->*LINKS).next = nullptr;
+        if (tail != nullptr)
+        {
+            (tail->*LINKS).next = item;
+        }
+        else
+        {
+            head = item;
+        }
+        tail = item;
+        count++;
+    }
+
+    void PushFront(T* item)
+    {
+        (item->*LINKS).prev = nullptr;
+        (item->*LINKS).next = head;
+        if (head != nullptr)
+        {
+            (head->*LINKS).prev = item;
+        }
+        else
+        {
+            tail = item;
+        }
+        head = item;
+        count++;
+    }
+
+    /*
+        Unlink an item that is on this list
+    */
+    void Remove(T* item)
+    {
+        ListLinks<T>& links = item->*LINKS;
+        if (links.prev != nullptr)
+        {
+            (links.prev->*LINKS).next = links.next;
+        }
+        else
+        {
+            head = links.next;
+        }
+        if (links.next != nullptr)
+        {
+            (links.next->*LINKS).prev = links.prev;
+        }
+        else
+        {
+            tail = links.prev;
+        }
+        links.prev = nullptr;
+        links.next = nullptr;
+        count--;
+    }
+
+    T* PopFront()
+    {
+        T* item = head;
+        if (item != nullptr)
+        {
+            Remove(item);
+        }
+        return item;
+    }
+
+    /*
+        Move every item of other onto the end of this list, leaving other empty
+    */
+    void SpliceBack(IntrusiveList& other)
+    {
+        if (other.head == nullptr)
+        {
+            return;
+        }
+        if (tail != nullptr)
+        {
+            (tail->*LINKS).next = other.head;
+            (other.head->*LINKS).prev = tail;
+        }
+        else
+        {
+            head = other.head;
+        }
+        tail = other.tail;
+        count += other.count;
+        other.head = nullptr;
+        other.tail = nullptr;
+        other.count = 0;
+    }
+
+    /*
+        Move every item of other onto the front of this list, leaving other empty
+    */
+    void SpliceFront(IntrusiveList& other)
+    {
+        other.SpliceBack(*this);
+        Swap(other);
+    }
+
+    void Swap(IntrusiveList& other)
+    {
+        T* h = head;
+        T* t = tail;
+        size_t c = count;
+        head = other.head;
+        tail = other.tail;
+        count = other.count;
+        other.head = h;
+        other.tail = t;
+        other.count = c;
+    }
+
+    /*
+        Forget every item (their links are left as they were)
+    */
+    void Clear()
+    {
+        head = nullptr;
+        tail = nullptr;
+        count = 0;
+    }
+
+    class Iterator
+    {
+    public:
+        explicit Iterator(T* item) : item(item) {}
+        T* operator*() const { return item; }
+        Iterator& operator++()
+        {
+            item = (item->*LINKS).next;
+            return *this;
+        }
+        bool operator!=(const Iterator& other) const { return item != other.item; }
+
+    private:
+        T* item;
+    };
+
+    Iterator begin() const { return Iterator(head); }
+    Iterator end() const { return Iterator(nullptr); }
+
+private:
+    T* head;
+    T* tail;
+    size_t count;
+};
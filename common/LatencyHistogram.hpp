@@ -0,0 +1,98 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+/*
+    HDR style histogram of non-negative integer durations (ticks)
+
+    Values below 2^SUB_BITS get a bucket each, so they are exact.
+    Above that, every power of 2 range is split into 2^(SUB_BITS - 1) equal buckets,
+    so a reported value is never off by more than 1 / 2^(SUB_BITS - 1) (~6%) of itself.
+    The counts live in a fixed array covering every 64 bit value:
+    recording is a count-leading-zeros, a shift and an add, with no allocation and no loop.
+*/
+class LatencyHistogram
+{
+public:
+    static const int SUB_BITS = 5;
+    static const uint64_t SUB_COUNT = uint64_t(1) << SUB_BITS;          // Buckets in the exact range
+    static const uint64_t HALF_COUNT = SUB_COUNT >> 1;                  // Buckets per power of 2 above it
+    static const size_t BUCKETS = (64 - SUB_BITS + 2) * HALF_COUNT;
+
+    LatencyHistogram() { Clear(); }
+
+    void Clear()
+    {
+        memset(counts, 0, sizeof(counts));
+        count = 0;
+        total = 0;
+        max = 0;
+    }
+
+    void Record(const uint64_t& value)
+    {
+        counts[BucketOf(value)]++;
+        count++;
+        total += value;
+        max = (value > max) ? value : max;
+    }
+
+    uint64_t Count() const { return count; }
+    uint64_t Max() const { return max; }
+    double Mean() const { return (count > 0) ? double(total) / double(count) : 0; }
+
+    /*
+        The smallest recorded value that at least the given fraction (0 to 1) of values are no greater than
+        Reported as the top of its bucket, so it errs on the high side
+    */
+    uint64_t Percentile(const double& fraction) const
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+        uint64_t rank = uint64_t(fraction * double(count) + 0.999999);
+        rank = (rank < 1) ? 1 : (rank > count ? count : rank);
+        uint64_t seen = 0;
+        for (size_t bucket = 0; bucket < BUCKETS; bucket++)
+        {
+            seen += counts[bucket];
+            if (seen >= rank)
+            {
+                uint64_t top = HighestIn(bucket);
+                return (top < max) ? top : max;
+            }
+        }
+        return max;
+    }
+
+private:
+    /*
+        Values below SUB_COUNT map to themselves.
+        Otherwise shift the value down until it has SUB_BITS significant bits;
+        the shift picks the power of 2 range, and the bits left pick the bucket inside it.
+    */
+    static size_t BucketOf(const uint64_t& value)
+    {
+        int magnitude = 63 - __builtin_clzll(value | 1);
+        int shift = magnitude - (SUB_BITS - 1);
+        shift &= ~(shift >> 31); // max(shift, 0) without a branch
+        return size_t(shift) * HALF_COUNT + size_t(value >> shift);
+    }
+
+    static uint64_t HighestIn(const size_t& bucket)
+    {
+        if (bucket < SUB_COUNT)
+        {
+            return bucket;
+        }
+        uint64_t shift = bucket / HALF_COUNT - 1;
+        uint64_t sub = bucket - shift * HALF_COUNT;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    uint64_t counts[BUCKETS];
+    uint64_t count;
+    uint64_t total;
+    uint64_t max;
+};
@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include <string_view>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+    A read only memory mapping of a whole file, unmapped when destroyed
+    An empty file opens successfully and maps nothing
+*/
+class MappedFile
+{
+public:
+    MappedFile() : data(nullptr), size(0) {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { Close(); }
+
+    /*
+        Map the file at the path specified
+        sequential hints the kernel to read ahead aggressively
+    */
+    bool Open(const char* filePath, const bool& sequential = false)
+    {
+        Close();
+        int fd = open(filePath, O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) < 0)
+        {
+            close(fd);
+            return false;
+        }
+        if (st.st_size > 0)
+        {
+            void* addr = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED)
+            {
+                close(fd);
+                return false;
+            }
+            if (sequential)
+            {
+                madvise(addr, size_t(st.st_size), MADV_SEQUENTIAL);
+            }
+            data = static_cast<const char*>(addr);
+            size = size_t(st.st_size);
+        }
+        close(fd); // The mapping keeps the file alive
+        return true;
+    }
+
+    void Close()
+    {
+        if (data != nullptr)
+        {
+            munmap(const_cast<char*>(data), size);
+        }
+        data = nullptr;
+        size = 0;
+    }
+
+    const char* Data() const { return data; }
+    size_t Size() const { return size; }
+    std::string_view View() const { return std::string_view(data, size); }
+
+private:
+    const char* data;
+    size_t size;
+};
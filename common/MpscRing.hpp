@@ -0,0 +1,112 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+
+/*
+    Bounded lock-free ring buffer, many producers & a single consumer
+
+    Every cell carries a sequence number that says whose turn it is:
+        sequence == position        the cell is free for the producer claiming that position
+        sequence == position + 1    the cell holds a value for the consumer reading that position
+    Producers claim positions with a compare & swap on the tail,
+    the lone consumer owns the head outright and never needs one.
+
+    Push & Pop never block, they return false when the ring is full / empty
+    and leave it to the caller to retry (or yield).
+*/
+template <typename T>
+class MpscRing
+{
+public:
+    /*
+        capacity is rounded up to a power of 2
+    */
+    explicit MpscRing(size_t capacity) : head(0), tail(0)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        mask = size - 1;
+        cells = std::vector<Cell>(size);
+        for (size_t i = 0; i < size; i++)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    /*
+        Any thread may push
+    Return:
+        bool --> false if the ring is full
+    */
+    bool Push(const T& value)
+    {
+        size_t position = tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(sequence) - intptr_t(position);
+            if (diff == 0)
+            {
+                // Our turn on this cell, if nobody beats us to the position
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    cell.value = value;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                // The consumer hasn't freed this cell yet
+                return false;
+            }
+            else
+            {
+                // Another producer took the position, try the newest one
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /*
+        Only the consumer thread may pop
+    Return:
+        bool --> false if the ring is empty
+    */
+    bool Pop(T& value)
+    {
+        Cell& cell = cells[head & mask];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (sequence != head + 1)
+        {
+            return false;
+        }
+        value = cell.value;
+        // Free the cell for whichever producer comes around the ring to it next
+        cell.sequence.store(head + mask + 1, std::memory_order_release);
+        head++;
+        return true;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+
+        Cell() : sequence(0), value() {}
+    };
+
+    std::vector<Cell> cells;
+    size_t mask;
+    alignas(64) size_t head;                // Consumer only
+    alignas(64) std::atomic<size_t> tail;   // Shared by the producers
+};
@@ -0,0 +1,162 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <type_traits>
+#include <unistd.h>
+
+/*
+    Buffered output for the simulators
+
+    Every line is appended to a large user-space buffer,
+    and the buffer goes out with a single write() once it fills (or on Flush).
+    Nothing here allocates: strings are copied straight in
+    and numbers are formatted in place with to_chars.
+
+    Usage:
+        out.Write("Job: ", job->name, " scheduled.\n");
+        out.Write(Column(job->name, 8), Column(job->pass, 6), '\n'); // same as "%-8s%-6d"
+*/
+
+/*
+    A value printed left justified in a column of the given width (printf's "%-Ns")
+    Values wider than the column are not truncated
+*/
+template <typename T>
+struct PaddedColumn
+{
+    const T& value;
+    size_t width;
+};
+
+template <typename T>
+PaddedColumn<T> Column(const T& value, const size_t& width)
+{
+    return PaddedColumn<T>{value, width};
+}
+
+class OutputSink
+{
+public:
+    static const size_t BUFFER_SIZE = 1 << 16;
+
+    explicit OutputSink(int fd = STDOUT_FILENO) : fd(fd), capture(nullptr), used(0) {}
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+    ~OutputSink() { Flush(); }
+
+    template <typename... Args>
+    void Write(const Args&... args)
+    {
+        (Put(args), ...);
+    }
+
+    /*
+        Send everything buffered so far out in one write
+    */
+    void Flush()
+    {
+        WriteAll(buffer, used);
+        used = 0;
+    }
+
+    /*
+        Collect the output in text instead of writing it to the file descriptor (nullptr to stop)
+        Whatever is buffered is flushed to where it was headed first
+    */
+    void CaptureTo(std::string* text)
+    {
+        Flush();
+        capture = text;
+    }
+
+private:
+    void Put(const std::string_view& text)
+    {
+        if (text.size() > BUFFER_SIZE - used)
+        {
+            Flush();
+            if (text.size() > BUFFER_SIZE)
+            {
+                // Too big to ever buffer, send it straight out
+                WriteAll(text.data(), text.size());
+                return;
+            }
+        }
+        memcpy(buffer + used, text.data(), text.size());
+        used += text.size();
+    }
+
+    void Put(const char* text) { Put(std::string_view(text)); }
+
+    void Put(const char& c)
+    {
+        if (used == BUFFER_SIZE)
+        {
+            Flush();
+        }
+        buffer[used++] = c;
+    }
+
+    template <typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+    void Put(const T& value)
+    {
+        // Enough room for any 64 bit value and its sign
+        if (BUFFER_SIZE - used < 24)
+        {
+            Flush();
+        }
+        used = std::to_chars(buffer + used, buffer + BUFFER_SIZE, value).ptr - buffer;
+    }
+
+    template <typename T>
+    void Put(const PaddedColumn<T>& col)
+    {
+        char digits[24];
+        std::string_view text = AsText(col.value, digits);
+        Put(text);
+        for (size_t pad = text.size(); pad < col.width; pad++)
+        {
+            Put(' ');
+        }
+    }
+
+    static std::string_view AsText(const std::string_view& text, char*) { return text; }
+
+    template <typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+    static std::string_view AsText(const T& value, char* digits)
+    {
+        return std::string_view(digits, std::to_chars(digits, digits + 24, value).ptr - digits);
+    }
+
+    void WriteAll(const char* data, size_t length)
+    {
+        if (capture != nullptr)
+        {
+            capture->append(data, length);
+            return;
+        }
+        while (length > 0)
+        {
+            ssize_t written = write(fd, data, length);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return; // Nowhere left to report to
+            }
+            data += written;
+            length -= size_t(written);
+        }
+    }
+
+    int fd;
+    std::string* capture; // Where the output goes instead of fd, nullptr when not capturing
+    size_t used;
+    char buffer[BUFFER_SIZE];
+};
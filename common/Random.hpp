@@ -0,0 +1,70 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+#include <string>
+#include <vector>
+
+/*
+    Seeded random numbers for the workload generators (p2 gen & bench, p3 -S simulation)
+
+    splitmix64, so the same seed gives the same stream on every platform,
+    and a generated trace or simulation can be reproduced from its seed alone.
+*/
+class SplitMix64
+{
+public:
+    explicit SplitMix64(const uint64_t& seed = 1) : state(seed) {}
+
+    uint64_t Next()
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    /*
+        Uniform in [0, 1)
+    */
+    double Uniform()
+    {
+        return double(Next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    /*
+        Geometric count (at least 1) with the given mean
+    */
+    uint64_t Geometric(const double& mean)
+    {
+        if (mean <= 1)
+        {
+            return 1;
+        }
+        double u = 1.0 - Uniform(); // (0, 1]
+        return 1 + uint64_t(log(u) / log(1.0 - 1.0 / mean));
+    }
+
+private:
+    uint64_t state;
+};
+
+/*
+    Split a distribution or profile spec such as "zipf:100:1.1" at its colons
+    An empty field stays in as an empty string, so the field count is always colons + 1
+*/
+inline std::vector<std::string> SplitSpec(const std::string& spec)
+{
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= spec.size())
+    {
+        size_t colon = spec.find(':', start);
+        if (colon == std::string::npos)
+        {
+            colon = spec.size();
+        }
+        parts.push_back(spec.substr(start, colon - start));
+        start = colon + 1;
+    }
+    return parts;
+}
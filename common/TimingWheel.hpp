@@ -0,0 +1,69 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/*
+    Hashed timing wheel of items due at whole ticks
+
+    The wheel has 2^slotBits slots and an item due at time T waits in slot T mod 2^slotBits.
+    Scheduling is an append, and each tick only looks at one slot:
+    items more than a lap ahead sit in it until their own lap comes round.
+    Items due on the same tick come out in the order they were scheduled.
+*/
+template <typename T>
+class TimingWheel
+{
+public:
+    explicit TimingWheel(const unsigned& slotBits = 12) :
+        slots(size_t(1) << slotBits), mask((size_t(1) << slotBits) - 1), now(0), count(0) {}
+
+    uint64_t Now() const { return now; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    /*
+        Add an item due at time (an item due before Now is due now)
+    */
+    void Schedule(uint64_t time, const T& item)
+    {
+        time = (time < now) ? now : time;
+        slots[time & mask].push_back(Entry{time, item});
+        count++;
+    }
+
+    /*
+        Append every item due at Now to due, then move on to the next tick
+    */
+    void Tick(std::vector<T>& due)
+    {
+        std::vector<Entry>& slot = slots[now & mask];
+        size_t kept = 0;
+        for (size_t i = 0; i < slot.size(); i++)
+        {
+            if (slot[i].time == now)
+            {
+                due.push_back(slot[i].item);
+            }
+            else
+            {
+                slot[kept++] = slot[i];
+            }
+        }
+        count -= slot.size() - kept;
+        slot.erase(slot.begin() + kept, slot.end());
+        now++;
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t time;
+        T item;
+    };
+
+    std::vector<std::vector<Entry>> slots;
+    size_t mask;
+    uint64_t now;
+    size_t count;
+};
@@ -0,0 +1,225 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <string_view>
+#include <charconv>
+#include "MappedFile.hpp"
+
+/*
+    Shared trace parsing for the scheduler simulators (p2 Stride, p3 MLFQ)
+
+    A trace is a text file holding one instruction per line:
+        opcode[,arg1[,arg2[,arg3]]]
+    i.e. "newjob,A,10", "newjob,A,10,tenant1", "unblock,A", "transfer,A,B,5" or "interrupt"
+
+    The file is mmapped and each line is tokenized in place.
+    Every argument handed back is a std::string_view into the mapping,
+    so nothing is copied or allocated while parsing.
+*/
+
+enum OPCODE {INVALID, NEWJOB, FINISH, INTERRUPT, BLOCK, UNBLOCK, RUNNABLE, RUNNING, BLOCKED, EPOCH, GROUP, CHECKPOINT, RESTORE,
+             SETPRI, TRANSFER, TIME, OPCODE_COUNT}; // OPCODE_COUNT must stay last
+
+struct TraceCommand
+{
+    OPCODE opcode;
+    std::string_view arg1;  // Usually a job name
+    int arg2;               // Usually a priority, -1 when absent (or not a number)
+    std::string_view arg2Text; // The second argument as written, for opcodes that take a name there
+    std::string_view arg3;  // Usually a group name, empty when absent
+};
+
+/*
+    Combine the length and first letter of an opcode into a single switch key
+*/
+constexpr uint32_t OpcodeKey(const size_t& length, const char& first)
+{
+    return (uint32_t(length) << 8) | uint8_t(first);
+}
+//--
+/*
+    Converts the text of an opcode into the proper ENUM
+    The length & first letter pick the candidate, one compare confirms it
+*/
+inline OPCODE ParseOpcode(const std::string_view& code)
+{
+    if (code.size() > 0)
+    {
+        switch (OpcodeKey(code.size(), code[0]))
+        {
+        case OpcodeKey(6, 'n'):
+            if (code == "newjob") return NEWJOB;
+            break;
+        case OpcodeKey(6, 'f'):
+            if (code == "finish") return FINISH;
+            break;
+        case OpcodeKey(9, 'i'):
+            if (code == "interrupt") return INTERRUPT;
+            break;
+        case OpcodeKey(5, 'b'):
+            if (code == "block") return BLOCK;
+            break;
+        case OpcodeKey(7, 'b'):
+            if (code == "blocked") return BLOCKED;
+            break;
+        case OpcodeKey(7, 'u'):
+            if (code == "unblock") return UNBLOCK;
+            break;
+        case OpcodeKey(7, 'r'):
+            if (code == "running") return RUNNING;
+            if (code == "restore") return RESTORE;
+            break;
+        case OpcodeKey(8, 'r'):
+            if (code == "runnable") return RUNNABLE;
+            break;
+        case OpcodeKey(5, 'e'):
+            if (code == "epoch") return EPOCH;
+            break;
+        case OpcodeKey(5, 'g'):
+            if (code == "group") return GROUP;
+            break;
+        case OpcodeKey(10, 'c'):
+            if (code == "checkpoint") return CHECKPOINT;
+            break;
+        case OpcodeKey(6, 's'):
+            if (code == "setpri") return SETPRI;
+            break;
+        case OpcodeKey(8, 't'):
+            if (code == "transfer") return TRANSFER;
+            break;
+        case OpcodeKey(4, 't'):
+            if (code == "time") return TIME;
+            break;
+        default:
+            break;
+        }
+    }
+    fprintf(stderr, "ERROR: Invalid instruction found:%.*s\n", int(code.size()), code.data());
+    return INVALID;
+}
+//--
+/*
+    The text of an opcode, the reverse of ParseOpcode
+*/
+inline const char* OpcodeName(const OPCODE& opcode)
+{
+    static const char* const NAMES[OPCODE_COUNT] = {"invalid", "newjob", "finish", "interrupt", "block", "unblock",
+                                        "runnable", "running", "blocked", "epoch", "group", "checkpoint", "restore",
+                                        "setpri", "transfer", "time"};
+    return (opcode < OPCODE_COUNT) ? NAMES[opcode] : "invalid";
+}
+//--
+/*
+    Split off everything up to (NOT including) the next comma
+    The comma itself is consumed from rest
+*/
+inline std::string_view NextField(std::string_view& rest)
+{
+    size_t cIndex = rest.find(',');
+    std::string_view field = rest.substr(0, cIndex);
+    rest.remove_prefix(cIndex == std::string_view::npos ? rest.size() : cIndex + 1);
+    return field;
+}
+//--
+/*
+    Given a line containing an instruction (i.e. "newjob,A,10")
+    Separate it into the appropriate details
+
+Return:
+    bool --> false if the line was blank and holds no instruction
+*/
+inline bool ParseTraceLine(std::string_view line, TraceCommand& cmd)
+{
+    // Trim trailing whitespace & carriage returns left over from CRLF files
+    while (line.size() > 0 && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t'))
+    {
+        line.remove_suffix(1);
+    }
+    if (line.size() == 0)
+    {
+        return false;
+    }
+
+    cmd.opcode = ParseOpcode(NextField(line));
+    cmd.arg1 = NextField(line);
+    cmd.arg2 = -1;
+    cmd.arg2Text = std::string_view();
+    if (line.size() > 0)
+    {
+        cmd.arg2Text = NextField(line);
+        std::from_chars(cmd.arg2Text.data(), cmd.arg2Text.data() + cmd.arg2Text.size(), cmd.arg2);
+    }
+    cmd.arg3 = NextField(line);
+    return true;
+}
+//--
+/*
+    Maps a trace file into memory and hands back one parsed instruction at a time
+    Commands handed back point into the mapping, and stay valid until the reader is destroyed
+*/
+class TraceReader
+{
+public:
+    TraceReader() : cursor(0) {}
+
+    /*
+        Map the file at the path specified
+        An empty file opens successfully but holds no instructions
+    */
+    bool Open(const char* filePath)
+    {
+        cursor = 0;
+        return file.Open(filePath, true);
+    }
+
+    /*
+        Parse the next non-blank line into cmd
+
+    Return:
+        bool --> false once the end of the file has been reached
+    */
+    bool Next(TraceCommand& cmd)
+    {
+        std::string_view line;
+        while (NextLine(line))
+        {
+            if (ParseTraceLine(line, cmd))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+        Hand back the next line as is (without its newline), blank or not
+
+    Return:
+        bool --> false once the end of the file has been reached
+    */
+    bool NextLine(std::string_view& line)
+    {
+        size_t size = file.Size();
+        if (cursor >= size)
+        {
+            return false;
+        }
+        const char* start = file.Data() + cursor;
+        const char* nl = static_cast<const char*>(memchr(start, '\n', size - cursor));
+        size_t length = (nl != nullptr) ? size_t(nl - start) : size - cursor;
+        cursor += length + 1;
+        line = std::string_view(start, length);
+        return true;
+    }
+
+    void Close()
+    {
+        file.Close();
+        cursor = 0;
+    }
+
+private:
+    MappedFile file;
+    size_t cursor;
+};
@@ -0,0 +1,211 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <charconv>
+#include "TraceParser.hpp"
+#include "MpscRing.hpp"
+
+/*
+    Several traces (streams) read at once and merged into one sequence of commands
+
+    Every line of a stream starts with a timestamp:
+        TIMESTAMP,opcode[,arg1[,arg2[,arg3]]]    i.e. "120,newjob,A,10"
+    and the timestamps within a stream must not go backwards.
+
+    Each stream gets its own producer thread, which maps & parses its file
+    and pushes the parsed commands into one shared MpscRing.
+    The consumer (the caller's thread) hands the commands on in timestamp order,
+    ties going to the stream listed first, so the merge is the same on every run
+    no matter how the producers happen to be scheduled.
+    A command is only handed on once every stream still open has something queued,
+    since until then a stream could still come up with an earlier timestamp.
+    So that a stream running far ahead of the others can't pile up without limit while they catch up,
+    a producer waits once STREAM_QUEUE_LIMIT of its commands are in the ring or queued and not yet handed on.
+*/
+class TraceStreams
+{
+public:
+    static const size_t RING_CAPACITY = 4096;
+    static const size_t STREAM_QUEUE_LIMIT = 1024;  // Commands of one stream parsed but not yet handed on
+
+    TraceStreams() : ring(RING_CAPACITY) {}
+
+    /*
+        Map every stream up front, so a bad path is reported before anything runs
+    */
+    bool Open(const std::vector<std::string>& filePaths)
+    {
+        paths = filePaths;
+        readers.clear();
+        inFlight = std::vector<std::atomic<size_t>>(paths.size());
+        for (std::atomic<size_t>& count : inFlight)
+        {
+            count.store(0, std::memory_order_relaxed);
+        }
+        for (const std::string& path : paths)
+        {
+            readers.push_back(std::make_unique<TraceReader>());
+            if (!readers.back()->Open(path.c_str()))
+            {
+                fprintf(stderr, "ERROR: Instruction file path could not be opened (%s)\n", path.c_str());
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*
+        Run every stream to the end, calling consume(const TraceCommand&) on each command in merged order
+        The commands point into the mapped files, which stay mapped until this object is destroyed
+    */
+    template <typename Consumer>
+    void Run(Consumer&& consume)
+    {
+        std::vector<std::thread> producers;
+        for (uint32_t stream = 0; stream < readers.size(); stream++)
+        {
+            producers.emplace_back(&TraceStreams::Produce, this, stream);
+        }
+
+        std::vector<std::deque<StreamCommand>> queued(readers.size()); // No more than STREAM_QUEUE_LIMIT each
+        std::vector<bool> open(readers.size(), true);
+        size_t openCount = readers.size();
+        for (;;)
+        {
+            bool progress = false;
+            StreamCommand item;
+            while (ring.Pop(item))
+            {
+                progress = true;
+                if (item.last)
+                {
+                    open[item.stream] = false;
+                    openCount--;
+                }
+                else
+                {
+                    queued[item.stream].push_back(item);
+                }
+            }
+
+            // Hand on the earliest command for as long as every open stream has one to compare against
+            for (;;)
+            {
+                size_t earliest = queued.size();
+                bool ready = true;
+                for (size_t stream = 0; stream < queued.size(); stream++)
+                {
+                    if (queued[stream].empty())
+                    {
+                        ready = ready && !open[stream];
+                    }
+                    else if (earliest == queued.size() || queued[stream].front().timestamp < queued[earliest].front().timestamp)
+                    {
+                        earliest = stream;
+                    }
+                }
+                if (!ready || earliest == queued.size())
+                {
+                    break;
+                }
+                consume(queued[earliest].front().cmd);
+                queued[earliest].pop_front();
+                inFlight[earliest].fetch_sub(1, std::memory_order_release);
+                progress = true;
+            }
+
+            if (openCount == 0 && !progress)
+            {
+                // Every stream has ended and everything queued has been handed on
+                break;
+            }
+            if (!progress)
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        for (std::thread& producer : producers)
+        {
+            producer.join();
+        }
+    }
+
+private:
+    struct StreamCommand
+    {
+        uint64_t timestamp;
+        uint32_t stream;
+        bool last;          // Marks the end of the stream, holds no command
+        TraceCommand cmd;
+    };
+
+    /*
+        Parse one stream into the ring, finishing with its end marker
+    */
+    void Produce(const uint32_t stream)
+    {
+        TraceReader& reader = *readers[stream];
+        StreamCommand item;
+        item.timestamp = 0;
+        item.stream = stream;
+        item.last = false;
+        std::string_view line;
+        while (reader.NextLine(line))
+        {
+            std::string_view rest = line;
+            std::string_view digits = NextField(rest);
+            uint64_t timestamp = 0;
+            std::from_chars_result result = std::from_chars(digits.data(), digits.data() + digits.size(), timestamp);
+            if (result.ec != std::errc() || result.ptr != digits.data() + digits.size())
+            {
+                if (ParseTraceLine(line, item.cmd))
+                {
+                    // Not blank, so it's missing its timestamp
+                    fprintf(stderr, "ERROR: Missing timestamp in %s:%.*s\n", paths[stream].c_str(), int(line.size()), line.data());
+                }
+                continue;
+            }
+            if (!ParseTraceLine(rest, item.cmd))
+            {
+                continue;
+            }
+            if (timestamp < item.timestamp)
+            {
+                fprintf(stderr, "ERROR: Timestamp goes backwards in %s:%.*s\n", paths[stream].c_str(), int(line.size()), line.data());
+                timestamp = item.timestamp; // Keep the stream's order
+            }
+            item.timestamp = timestamp;
+            while (inFlight[stream].load(std::memory_order_acquire) >= STREAM_QUEUE_LIMIT)
+            {
+                // Far enough ahead of the merge, let the other streams catch up
+                std::this_thread::yield();
+            }
+            inFlight[stream].fetch_add(1, std::memory_order_relaxed);
+            PushWait(item);
+        }
+        item.last = true;
+        PushWait(item);
+    }
+
+    void PushWait(const StreamCommand& item)
+    {
+        while (!ring.Push(item))
+        {
+            // The consumer is behind, let it catch up
+            std::this_thread::yield();
+        }
+    }
+
+    std::vector<std::string> paths;
+    std::vector<std::unique_ptr<TraceReader>> readers;
+    MpscRing<StreamCommand> ring;
+    std::vector<std::atomic<size_t>> inFlight;  // Per stream, commands pushed but not yet handed on (its end marker aside)
+};
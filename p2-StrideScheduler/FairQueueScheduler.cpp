@@ -0,0 +1,501 @@
+#include "FairQueueScheduler.hpp"
+
+using namespace std;
+
+FairQueueScheduler::FairQueueScheduler(const bool& eligibility) : eligibility(eligibility)
+{
+    virtualTime = 0;
+    totalWeight = 0;
+    systemRunning = false;
+    currRunningJob = nullptr;
+    verbose = true;
+}
+//--
+FairQueueScheduler::~FairQueueScheduler()
+{
+    // Every job in the system (running, runnable or blocked) is in the index
+    for(unordered_map<string_view, Job*>::iterator it = jobIndex.begin(); it != jobIndex.end(); it++)
+    {
+        delete it->second;
+    }
+}
+//--
+/*
+    Map in the file via the path specified
+    And execute the instruction found on each line
+*/
+void FairQueueScheduler::RunInstructionFile(const std::string& filePath)
+{
+    TraceReader trace;
+    if(!trace.Open(filePath.c_str())){
+        fprintf(stderr, "ERROR: Instruction file path could not be opened (%s)\n", filePath.c_str());
+        out.Flush();
+        exit(1);
+    }
+    TraceCommand cmd;
+    while(trace.Next(cmd))
+    {
+        RunCommand(cmd);
+    }
+}
+//--
+void FairQueueScheduler::RunInstructionString(std::string_view line)
+{
+    TraceCommand cmd;
+    if(ParseTraceLine(line, cmd))
+    {
+        RunCommand(cmd);
+    }
+}
+//--
+/*
+Given an instruction already parsed by the trace parser, run the desired instruction
+
+Instruct List
+    opcode	    argument 1  argument 2  meaning
+    newjob	    NAME	    PRIORITY	A new job with weight PRIORITY has arrived
+    setpri      NAME        PRIORITY    Change the named job's weight (running, runnable or blocked)
+    finish			                    The currently running job has terminated - it is an error if the system is idle
+    interrupt			                A timer interrupt has occurred - the earliest (eligible) finish runs next
+    block			                    The currently running job has become blocked
+    unblock	    NAME		            The named job becomes unblocked - it is an error if it was not blocked
+    runnable			                Print information about the jobs waiting to run
+    running			                    Print information about the currently running job
+    blocked			                    Print information about the jobs on the blocked queue
+
+    group, checkpoint, restore, transfer, time are stride only: they are reported as errors
+*/
+void FairQueueScheduler::RunCommand(const TraceCommand& cmd)
+{
+    stats.instructions++;
+    switch (cmd.opcode)
+    {
+        case NEWJOB:
+        {
+            CreateNewJob(cmd.arg1, cmd.arg2);
+            break;
+        }
+        case SETPRI:
+        {
+            SetPriority(cmd.arg1, cmd.arg2);
+            break;
+        }
+        case INTERRUPT:
+        {
+            Interrupt();
+            break;
+        }
+        case BLOCK:
+        {
+            Block();
+            break;
+        }
+        case UNBLOCK:
+        {
+            UnBlock(cmd.arg1);
+            break;
+        }
+        case FINISH:
+        {
+            FinishJob();
+            break;
+        }
+        case RUNNING:
+        {
+            PrintRunningTask();
+            break;
+        }
+        case RUNNABLE:
+        {
+            PrintRunnables();
+            break;
+        }
+        case BLOCKED:
+        {
+            PrintBlockedTasks();
+            break;
+        }
+        case GROUP:
+        case CHECKPOINT:
+        case RESTORE:
+        case TRANSFER:
+        case TIME:
+        {
+            // Stride only, a trace relying on them would silently give different results here
+            stats.errors++;
+            fprintf(stderr, "ERROR: Instruction not supported by the weighted fair queuing policy:%s\n", OpcodeName(cmd.opcode));
+            break;
+        }
+        case INVALID:
+        default:
+        {
+            break;
+        }
+    }
+}
+//--
+void FairQueueScheduler::SetVerbose(const bool& on)
+{
+    verbose = on;
+}
+//--
+/*
+    Send the output into text rather than stdout (nullptr goes back to stdout), as Scheduler::CaptureOutput does
+*/
+void FairQueueScheduler::CaptureOutput(std::string* text)
+{
+    out.CaptureTo(text);
+}
+//--
+void FairQueueScheduler::FlushOutput()
+{
+    out.Flush();
+}
+//--
+void FairQueueScheduler::PrintSummary()
+{
+    stats.Print(out, eligibleJobs.size() + waitingJobs.size(), (currRunningJob != nullptr) ? 1 : 0, blockedJobs.size());
+    out.Flush();
+}
+//--
+/*
+    Give a job its virtual start, and the finish that follows from its priority
+*/
+void FairQueueScheduler::Stamp(Job* job, const uint64_t& start)
+{
+    job->start = start;
+    job->finish = start + (uint64_t(WFQ_QUANTUM) << WFQ_FRACTION_BITS) / uint64_t(job->priority);
+}
+//--
+/*
+    Add a job to the runnables
+    Under WF2Q+ a job that starts in the (virtual) future waits until the virtual time reaches it
+*/
+void FairQueueScheduler::Enqueue(Job* job)
+{
+    job->eligible = !eligibility || job->start <= virtualTime;
+    if(job->eligible)
+    {
+        eligibleJobs.insert(job);
+    }
+    else
+    {
+        waitingJobs.insert(job);
+    }
+}
+//--
+void FairQueueScheduler::Dequeue(Job* job)
+{
+    if(job->eligible)
+    {
+        eligibleJobs.erase(job);
+    }
+    else
+    {
+        waitingJobs.erase(job);
+    }
+}
+//--
+/*
+    Take the eligible job with the earliest finish out of the runnables
+    Returns nullptr if there are no runnables
+*/
+FairQueueScheduler::Job* FairQueueScheduler::PickNext()
+{
+    if(eligibleJobs.size() == 0 && waitingJobs.size() > 0)
+    {
+        // WF2Q+: the virtual time never lags behind every job
+        virtualTime = max(virtualTime, (*waitingJobs.begin())->start);
+    }
+    // Jobs whose start has come round become eligible
+    while(waitingJobs.size() > 0 && (*waitingJobs.begin())->start <= virtualTime)
+    {
+        Job* job = *waitingJobs.begin();
+        waitingJobs.erase(waitingJobs.begin());
+        job->eligible = true;
+        eligibleJobs.insert(job);
+    }
+    if(eligibleJobs.size() == 0)
+    {
+        return nullptr;
+    }
+    Job* job = *eligibleJobs.begin();
+    eligibleJobs.erase(eligibleJobs.begin());
+    return job;
+}
+//--
+/*
+    OPCODE: newjob
+    MEANING: A new job with weight PRIORITY and NAME has arrived, starting at the current virtual time
+
+    A new job's arrival does not cause a rescheduling unless the system was idle.
+*/
+void FairQueueScheduler::CreateNewJob(string_view name, const int& priority)
+{
+    if(priority < 1)
+    {
+        stats.errors++;
+        Report("Error. Job: ", name, " needs a priority of at least 1.\n");
+        return;
+    }
+    Job* nJob = new Job(name, priority);
+    jobIndex.emplace(nJob->name, nJob);
+    Stamp(nJob, virtualTime);
+    totalWeight += uint64_t(priority);
+    Enqueue(nJob);
+    stats.newJobs++;
+    Report("New job: ", nJob->name, " added with priority: ", priority, '\n');
+
+    if(!systemRunning)
+    {
+        Reschedule();
+    }
+}
+//--
+/*
+    OPCODE: setpri
+    SYNTAX: setpri,A,50
+    MEANING: The named job's weight is changed, wherever the job is.
+    Its start stays put and its finish is worked out again from the new weight,
+    a runnable job is re-keyed in O(log n).
+*/
+void FairQueueScheduler::SetPriority(string_view name, const int& priority)
+{
+    unordered_map<string_view, Job*>::iterator it = jobIndex.find(name);
+    if(it == jobIndex.end())
+    {
+        stats.errors++;
+        Report("Error. Job: ", name, " does not exist.\n");
+        return;
+    }
+    if(priority < 1)
+    {
+        stats.errors++;
+        Report("Error. Job: ", name, " needs a priority of at least 1.\n");
+        return;
+    }
+    Job* job = it->second;
+    bool blocked = blockedJobs.count(job->name) > 0;
+    bool runnable = !blocked && job != currRunningJob;
+    if(runnable)
+    {
+        Dequeue(job);
+    }
+    if(!blocked)
+    {
+        totalWeight = totalWeight - uint64_t(job->priority) + uint64_t(priority);
+    }
+    job->priority = priority;
+    Stamp(job, job->start);
+    if(runnable)
+    {
+        Enqueue(job);
+    }
+    stats.priorityChanges++;
+    Report("Job: ", job->name, " priority set to: ", priority, ". Finish set to: ", Whole(job->finish), '\n');
+}
+//--
+/*
+    OPCODE: finish
+    MEANING:    The currently running job has completed and should be removed from the system.
+                If the system is idle, it is an error.
+*/
+void FairQueueScheduler::FinishJob()
+{
+    if(systemRunning)
+    {
+        stats.completed++;
+        Report("Job: ", currRunningJob->name, " completed.\n");
+        totalWeight -= uint64_t(currRunningJob->priority);
+        jobIndex.erase(currRunningJob->name);
+        delete currRunningJob;
+        currRunningJob = nullptr;
+        Reschedule();
+    }
+    else
+    {
+        stats.errors++;
+        Report("Error. System is idle.\n");
+    }
+}
+//--
+/*
+    Run the eligible job with the earliest finish
+    The job that was running is put back first, so it competes like every other job
+*/
+void FairQueueScheduler::Reschedule()
+{
+    if(currRunningJob != nullptr)
+    {
+        Enqueue(currRunningJob);
+    }
+    currRunningJob = PickNext();
+    if(currRunningJob != nullptr)
+    {
+        systemRunning = true;
+        stats.schedules++;
+        Report("Job: ", currRunningJob->name, " scheduled.\n");
+    }
+    else
+    {
+        stats.idles++;
+        Report("System is idle.\n");
+        systemRunning = false;
+    }
+}
+//--
+/*
+    OPCODE: interrupt
+    MEANING:    The currently running task has completed its quantum.
+    It is charged for the quantum (its next start is this finish), and the virtual time moves on.
+    It is an error if 'interrupt' is received when the system is idle.
+*/
+void FairQueueScheduler::Interrupt()
+{
+    if(systemRunning)
+    {
+        stats.interrupts++;
+        virtualTime += (uint64_t(WFQ_QUANTUM) << WFQ_FRACTION_BITS) / totalWeight;
+        Stamp(currRunningJob, currRunningJob->finish);
+        Reschedule();
+    }
+    else
+    {
+        stats.errors++;
+        Report("Error. System is idle.\n");
+    }
+}
+//--
+/*
+    OPCODE: block
+    MEANING: The currently running task has become blocked, its weight stops counting.
+    It is an error if the system is idle.
+*/
+void FairQueueScheduler::Block()
+{
+    if(systemRunning)
+    {
+        Job* bljb = currRunningJob;
+        totalWeight -= uint64_t(bljb->priority);
+        blockedJobs[bljb->name] = bljb;
+        stats.blocks++;
+        Report("Job: ", bljb->name, " blocked.\n");
+        currRunningJob = nullptr;
+        Reschedule();
+    }
+    else
+    {
+        stats.errors++;
+        Report("Error. System is idle.\n");
+    }
+}
+//--
+/*
+    OPCODE: unblock
+    SYNTAX: unblock,A
+    MEANING: The named job has become unblocked.
+    It starts again at the later of the virtual time and its last finish,
+    so time spent blocked earns it no credit.
+
+    It is an error if the named job was not blocked.
+    The scheduler is not run unless the system was idle.
+*/
+void FairQueueScheduler::UnBlock(string_view name)
+{
+    map<string, Job*, less<>>::iterator blIt = blockedJobs.find(name);
+    if(blIt != blockedJobs.end())
+    {
+        Job* unblockedJob = blIt->second;
+        blockedJobs.erase(blIt);
+
+        Stamp(unblockedJob, max(virtualTime, unblockedJob->finish));
+        totalWeight += uint64_t(unblockedJob->priority);
+        Enqueue(unblockedJob);
+        stats.unblocks++;
+        Report("Job: ", unblockedJob->name, " has unblocked. Start set to: ", Whole(unblockedJob->start), '\n');
+        if(!systemRunning)
+        {
+            Reschedule();
+        }
+    }
+    else
+    {
+        stats.errors++;
+        Report("Error. Job: ", name, " not blocked.\n");
+    }
+}
+//--
+/*
+    Print one row of a job listing
+    Matches the "NAME    START       FINISH      PRI" heading
+*/
+void FairQueueScheduler::PrintJob(const Job* job)
+{
+    Report(Column(job->name, 8), Column(Whole(job->start), 12), Column(Whole(job->finish), 12), Column(job->priority, 6), '\n');
+}
+//--
+/*
+    OPCODE: runnable
+    MEANING: The runnables, if any, are listed.
+    Eligible jobs come first by finish, followed by (WF2Q+) the jobs still waiting for their start, by start.
+*/
+void FairQueueScheduler::PrintRunnables()
+{
+    Report("Runnable:\n");
+    if(eligibleJobs.size() + waitingJobs.size() > 0)
+    {
+        Report("NAME    START       FINISH      PRI\n");
+        for(Job* job : eligibleJobs)
+        {
+            PrintJob(job);
+        }
+        for(Job* job : waitingJobs)
+        {
+            PrintJob(job);
+        }
+    }
+    else
+    {
+        Report("None\n");
+    }
+}
+//--
+/*
+    OPCODE: running
+    MEANING:    The running task is described (if system is not idle).
+*/
+void FairQueueScheduler::PrintRunningTask()
+{
+    Report("Running:\n");
+    if(currRunningJob != nullptr)
+    {
+        Report("NAME    START       FINISH      PRI\n");
+        PrintJob(currRunningJob);
+    }
+    else
+    {
+        Report("None\n");
+    }
+}
+//--
+/*
+    OPCODE: blocked
+    MEANING: The blocked tasks are listed, if any.
+*/
+void FairQueueScheduler::PrintBlockedTasks()
+{
+    Report("Blocked:\n");
+    if(blockedJobs.size() > 0)
+    {
+        Report("NAME    START       FINISH      PRI\n");
+        for(map<string, Job*, less<>>::iterator it = blockedJobs.begin(); it != blockedJobs.end(); it++)
+        {
+            PrintJob(it->second);
+        }
+    }
+    else
+    {
+        Report("None\n");
+    }
+}
+//--
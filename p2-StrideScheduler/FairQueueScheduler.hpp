@@ -0,0 +1,130 @@
+#pragma once
+#include <stdio.h>
+#include <string>
+#include <string_view>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include "TraceParser.hpp"
+#include "OutputSink.hpp"
+#include "SchedulerStats.hpp"
+
+// Virtual time a job of priority 1 is charged for one quantum
+#define WFQ_QUANTUM 1000000
+// Fractional bits kept in virtual times, so dividing a quantum by a large total weight still moves time on
+#define WFQ_FRACTION_BITS 12
+
+/*
+    Weighted fair queuing, driven by the same trace language as Scheduler
+    A job's priority is its weight.
+
+    Every job competing for the CPU carries a virtual start and finish time:
+        start = max(system virtual time, its last finish)  when it arrives or unblocks
+        start = its last finish                             after each quantum it runs
+        finish = start + WFQ_QUANTUM / priority
+    and the job with the earliest finish runs next.
+    The system virtual time moves WFQ_QUANTUM / (total weight of the competing jobs) per quantum.
+    Virtual times are fixed point with WFQ_FRACTION_BITS below the point, so neither division loses enough to skew them
+    (without them, time would stop once the total weight passed WFQ_QUANTUM), and are listed as whole units.
+
+    WFQ considers every competing job.
+    WF2Q+ only considers the eligible ones, those whose start has been reached by the system virtual time,
+    and moves the virtual time up to the earliest start whenever it falls behind every job.
+    That keeps a heavy job from running far ahead of its share, bounding each job's lag to about one quantum.
+    Eligible jobs are kept ordered by finish and the rest ordered by start,
+    so picking the next job, and making jobs eligible as time passes, each cost O(log n).
+*/
+class FairQueueScheduler{
+public:
+    FairQueueScheduler(const bool& eligibility = true);
+    ~FairQueueScheduler();
+    void RunInstructionFile(const std::string& filePath);
+    void RunInstructionString(std::string_view line);
+    void RunCommand(const TraceCommand& cmd);
+    void SetVerbose(const bool& on);
+    void CaptureOutput(std::string* text);
+    void FlushOutput();
+    void PrintSummary();
+private:
+
+    struct Job{
+        Job(std::string_view n, int p) : name(n), priority(p), start(0), finish(0), eligible(false) {}
+
+        std::string name;
+        int priority;
+        uint64_t start;     // Virtual start time (fixed point)
+        uint64_t finish;    // Virtual finish time (fixed point)
+        bool eligible;      // In eligibleJobs rather than waitingJobs
+    };
+
+    /*
+        Earliest virtual finish first, ties go to whichever is first alphabetically by name
+    */
+    struct FinishOrder{
+        bool operator()(const Job* a, const Job* b) const
+        {
+            if(a->finish != b->finish)
+            {
+                return a->finish < b->finish;
+            }
+            return a->name < b->name;
+        }
+    };
+
+    /*
+        Earliest virtual start first, ties go to whichever is first alphabetically by name
+    */
+    struct StartOrder{
+        bool operator()(const Job* a, const Job* b) const
+        {
+            if(a->start != b->start)
+            {
+                return a->start < b->start;
+            }
+            return a->name < b->name;
+        }
+    };
+
+    // Methods
+    void Enqueue(Job* job);
+    void Dequeue(Job* job);
+    Job* PickNext();
+    void Stamp(Job* job, const uint64_t& start);
+    static uint64_t Whole(const uint64_t& time) { return time >> WFQ_FRACTION_BITS; }
+    void CreateNewJob(std::string_view name, const int &priority);
+    void SetPriority(std::string_view name, const int &priority);
+    void Reschedule();
+
+    void FinishJob();
+    void Interrupt();
+    void Block();
+    void UnBlock(std::string_view name);
+    void PrintRunnables();
+    void PrintRunningTask();
+    void PrintBlockedTasks();
+    void PrintJob(const Job* job);
+
+    // Per event output, dropped entirely when not verbose
+    template <typename... Args>
+    void Report(const Args&... args)
+    {
+        if(verbose)
+        {
+            out.Write(args...);
+        }
+    }
+
+    // Data Members
+    std::set<Job*, FinishOrder> eligibleJobs;   // Runnable jobs that may be picked
+    std::set<Job*, StartOrder> waitingJobs;     // Runnable jobs whose start is still ahead of the virtual time (WF2Q+ only)
+    std::map<std::string, Job*, std::less<>> blockedJobs;
+    std::unordered_map<std::string_view, Job*> jobIndex; // Every job in the system by name, keys view the job's own name
+    uint64_t virtualTime;   // Fixed point, WFQ_FRACTION_BITS below the point
+    uint64_t totalWeight;   // Priorities of the runnable & running jobs
+    bool eligibility;       // WF2Q+ when set, plain WFQ when not
+    Job* currRunningJob;
+    bool systemRunning;
+    bool verbose;
+    SchedulerStats stats;
+    OutputSink out;
+};
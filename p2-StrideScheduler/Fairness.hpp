@@ -0,0 +1,287 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+    Per job fairness & latency bookkeeping for the stride & lottery simulators
+
+    Shares are counted in quanta (one per interrupt).
+    Waits are measured on the scheduler's own clock, handed in as now, so they agree with its latency histograms
+    and take in any time the time opcode moves it on by.
+    A job's ideal share is what an exact proportional share scheduler would have given it:
+    each quantum is split among the runnable & running jobs in proportion to their priorities,
+    which is the share stride scheduling aims for with stride = STRIDE_PROP / priority.
+    NOTE: groups are not taken into account, the ideal is the flat (single level) one.
+
+    Nothing here walks the jobs. A shared clock (quanta per ticket handed out so far)
+    lets each job work out its ideal share on demand, so every event is O(1).
+
+    Lag (ideal - received) only grows while a job waits and only shrinks while it runs,
+    so its extremes always land on one of the job's own events.
+    Sampling at those events gives the exact maximum.
+*/
+
+struct FairnessRecord
+{
+    FairnessRecord() : tickets(0), active(false), quanta(0), idealBase(0), clockStart(0), maxLag(0),
+        readySince(0), waits(0), waitTotal(0), waitMax(0), blockCycles(0) {}
+
+    uint64_t tickets;       // Weight in the ideal share (the job's priority)
+    bool active;            // Runnable or running, competing for the CPU
+    uint64_t quanta;        // Quanta actually received
+    double idealBase;       // Ideal quanta earned over earlier active periods
+    double clockStart;      // Share clock when the current active period began
+    double maxLag;          // Largest |ideal - received| seen
+    uint64_t readySince;    // Scheduler clock when the job last became runnable
+    uint64_t waits;         // Number of times it waited to be scheduled
+    uint64_t waitTotal;     // Total ticks spent waiting
+    uint64_t waitMax;       // Longest single wait
+    uint64_t blockCycles;   // Number of times it blocked
+};
+
+/*
+    A finished job's final numbers, kept for the export at exit
+*/
+struct FairnessResult
+{
+    std::string name;
+    std::string group;
+    FairnessRecord record;
+    double ideal;
+};
+
+class FairnessTracker
+{
+public:
+    FairnessTracker() : shareClock(0), activeTickets(0) {}
+
+    /*
+        The job starts competing (new or unblocked) and is waiting to be scheduled
+    */
+    void Activate(FairnessRecord& rec, const int& priority, const uint64_t& now)
+    {
+        rec.tickets = (priority > 0) ? uint64_t(priority) : 0;
+        rec.active = true;
+        rec.clockStart = shareClock;
+        rec.readySince = now;
+        activeTickets += rec.tickets;
+    }
+
+    /*
+        The job stops competing (blocked or finished)
+    */
+    void Deactivate(FairnessRecord& rec)
+    {
+        SampleLag(rec);
+        rec.idealBase = Ideal(rec);
+        rec.active = false;
+        activeTickets -= rec.tickets;
+    }
+
+    /*
+        The job's priority changed (setpri / transfer)
+        What it earned so far is banked at the old weight, and it earns at the new one from here on
+    */
+    void Reweight(FairnessRecord& rec, const int& priority)
+    {
+        uint64_t newTickets = (priority > 0) ? uint64_t(priority) : 0;
+        if (rec.active)
+        {
+            SampleLag(rec);
+            rec.idealBase = Ideal(rec);
+            rec.clockStart = shareClock;
+            activeTickets = activeTickets - rec.tickets + newTickets;
+        }
+        rec.tickets = newTickets;
+    }
+
+    void Scheduled(FairnessRecord& rec, const uint64_t& now)
+    {
+        SampleLag(rec);
+        uint64_t wait = now - rec.readySince;
+        rec.waits++;
+        rec.waitTotal += wait;
+        if (wait > rec.waitMax)
+        {
+            rec.waitMax = wait;
+        }
+    }
+
+    void Descheduled(FairnessRecord& rec, const uint64_t& now)
+    {
+        SampleLag(rec);
+        rec.readySince = now;
+    }
+
+    void Blocked(FairnessRecord& rec)
+    {
+        rec.blockCycles++;
+        Deactivate(rec);
+    }
+
+    /*
+        The running job used up a quantum
+    */
+    void Quantum(FairnessRecord& running)
+    {
+        if (activeTickets > 0)
+        {
+            shareClock += 1.0 / double(activeTickets);
+        }
+        running.quanta++;
+        SampleLag(running);
+    }
+
+    double Ideal(const FairnessRecord& rec) const
+    {
+        if (!rec.active)
+        {
+            return rec.idealBase;
+        }
+        return rec.idealBase + double(rec.tickets) * (shareClock - rec.clockStart);
+    }
+
+    double Lag(const FairnessRecord& rec) const
+    {
+        return Ideal(rec) - double(rec.quanta);
+    }
+
+    void SampleLag(FairnessRecord& rec)
+    {
+        double lag = Lag(rec);
+        double magnitude = (lag < 0) ? -lag : lag;
+        if (magnitude > rec.maxLag)
+        {
+            rec.maxLag = magnitude;
+        }
+    }
+
+private:
+    double shareClock;      // Ideal quanta earned so far by a job holding one ticket
+    uint64_t activeTickets; // Tickets held by runnable & running jobs
+};
+
+/*
+    Write one row (CSV) or object (JSON) per job
+    A path ending in ".json" gets JSON, anything else gets CSV
+    Job & group names come straight from the trace, so they are escaped:
+    CSV quotes a field holding a comma, quote or line break and doubles its quotes (RFC 4180),
+    JSON backslash escapes quotes, backslashes & control characters.
+*/
+class FairnessExporter
+{
+public:
+    FairnessExporter() : file(nullptr), json(false), first(true) {}
+    ~FairnessExporter() { Close(); }
+
+    bool Open(const std::string& filePath)
+    {
+        file = fopen(filePath.c_str(), "w");
+        if (file == nullptr)
+        {
+            return false;
+        }
+        json = filePath.size() >= 5 && filePath.compare(filePath.size() - 5, 5, ".json") == 0;
+        if (json)
+        {
+            fprintf(file, "[\n");
+        }
+        else
+        {
+            fprintf(file, "name,group,state,priority,quanta,ideal,lag,max_lag,waits,avg_wait,max_wait,block_cycles\n");
+        }
+        return true;
+    }
+
+    void Write(std::string_view name, std::string_view group, const char* state, const FairnessRecord& rec, const double& ideal)
+    {
+        double avgWait = (rec.waits > 0) ? double(rec.waitTotal) / double(rec.waits) : 0;
+        double lag = ideal - double(rec.quanta);
+        if (json)
+        {
+            fprintf(file, "%s  {\"name\": ", first ? "" : ",\n");
+            WriteJsonString(name);
+            fprintf(file, ", \"group\": ");
+            WriteJsonString(group);
+            fprintf(file, ", \"state\": \"%s\", \"priority\": %llu, "
+                          "\"quanta\": %llu, \"ideal\": %.3f, \"lag\": %.3f, \"max_lag\": %.3f, \"waits\": %llu, "
+                          "\"avg_wait\": %.3f, \"max_wait\": %llu, \"block_cycles\": %llu}",
+                    state, (unsigned long long)rec.tickets, (unsigned long long)rec.quanta, ideal, lag, rec.maxLag,
+                    (unsigned long long)rec.waits, avgWait, (unsigned long long)rec.waitMax,
+                    (unsigned long long)rec.blockCycles);
+        }
+        else
+        {
+            WriteCsvField(name);
+            fputc(',', file);
+            WriteCsvField(group);
+            fprintf(file, ",%s,%llu,%llu,%.3f,%.3f,%.3f,%llu,%.3f,%llu,%llu\n",
+                    state, (unsigned long long)rec.tickets, (unsigned long long)rec.quanta, ideal, lag, rec.maxLag,
+                    (unsigned long long)rec.waits, avgWait, (unsigned long long)rec.waitMax,
+                    (unsigned long long)rec.blockCycles);
+        }
+        first = false;
+    }
+
+    void Close()
+    {
+        if (file != nullptr)
+        {
+            if (json)
+            {
+                fprintf(file, "%s]\n", first ? "" : "\n");
+            }
+            fclose(file);
+            file = nullptr;
+        }
+    }
+
+private:
+    void WriteCsvField(std::string_view text)
+    {
+        if (text.find_first_of(",\"\r\n") == std::string_view::npos)
+        {
+            fwrite(text.data(), 1, text.size(), file);
+            return;
+        }
+        fputc('"', file);
+        for (char c : text)
+        {
+            if (c == '"')
+            {
+                fputc('"', file);
+            }
+            fputc(c, file);
+        }
+        fputc('"', file);
+    }
+
+    void WriteJsonString(std::string_view text)
+    {
+        fputc('"', file);
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                fputc('\\', file);
+                fputc(c, file);
+            }
+            else if ((unsigned char)c < 0x20)
+            {
+                fprintf(file, "\\u%04x", (unsigned)(unsigned char)c);
+            }
+            else
+            {
+                fputc(c, file);
+            }
+        }
+        fputc('"', file);
+    }
+
+    FILE* file;
+    bool json;
+    bool first;
+};
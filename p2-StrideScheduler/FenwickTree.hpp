@@ -0,0 +1,86 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+/*
+    Fenwick (binary indexed) tree over per slot weights
+
+    Changing a weight, summing the weights, and finding which slot
+    a number in [0, Total()) falls into all take O(log n),
+    which is what lets a lottery pick its winner without walking every job.
+*/
+class FenwickTree
+{
+public:
+    FenwickTree() : total(0), topBit(0) {}
+
+    size_t Size() const { return weights.size(); }
+    uint64_t Total() const { return total; }
+    uint64_t Weight(const size_t& slot) const { return weights.at(slot); }
+
+    /*
+        Grow to hold the given number of slots, new slots start at weight 0
+        The tree is rebuilt from the weights in O(n)
+    */
+    void Resize(const size_t& slots)
+    {
+        weights.resize(slots, 0);
+        tree.assign(slots + 1, 0);
+        for (size_t i = 1; i <= slots; i++)
+        {
+            tree[i] += weights[i - 1];
+            size_t parent = i + (i & (~i + 1));
+            if (parent <= slots)
+            {
+                tree[parent] += tree[i];
+            }
+        }
+        topBit = 1;
+        while ((topBit << 1) <= slots)
+        {
+            topBit <<= 1;
+        }
+    }
+
+    /*
+        Replace the weight held by a slot
+    */
+    void Set(const size_t& slot, const uint64_t& weight)
+    {
+        uint64_t old = weights.at(slot);
+        weights[slot] = weight;
+        total = total - old + weight;
+        // Unsigned wraparound makes adding (weight - old) work for decreases too
+        for (size_t i = slot + 1; i < tree.size(); i += (i & (~i + 1)))
+        {
+            tree[i] += weight - old;
+        }
+    }
+
+    /*
+        Find the slot whose run of weight covers target
+        Slots are laid end to end: slot 0 covers [0, w0), slot 1 covers [w0, w0 + w1), ...
+
+    Args:
+        const uint64_t target --> Must be less than Total()
+    */
+    size_t Find(uint64_t target) const
+    {
+        size_t pos = 0;
+        for (size_t step = topBit; step > 0; step >>= 1)
+        {
+            if (pos + step < tree.size() && tree[pos + step] <= target)
+            {
+                pos += step;
+                target -= tree[pos];
+            }
+        }
+        return pos; // tree is 1 based, so pos is already the 0 based slot
+    }
+
+private:
+    std::vector<uint64_t> tree;     // 1 based partial sums
+    std::vector<uint64_t> weights;  // 0 based, one per slot
+    uint64_t total;
+    size_t topBit;                  // Highest power of two <= Size()
+};
@@ -0,0 +1,518 @@
+#include "LotteryScheduler.hpp"
+
+using namespace std;
+
+LotteryScheduler::LotteryScheduler(const uint64_t& seed) : rng(seed)
+{
+    systemRunning = false;
+    currRunningJob = nullptr;
+    verbose = true;
+    clock = 0;
+    keepFinished = false;
+}
+//--
+LotteryScheduler::~LotteryScheduler()
+{
+    // Every job in the system (running, idle or blocked) owns exactly one slot
+    for(Job* job : slotJobs)
+    {
+        delete job;
+    }
+}
+//--
+/*
+    Map in the file via the path specified
+    And execute the instruction found on each line
+*/
+void LotteryScheduler::RunInstructionFile(const std::string& filePath)
+{
+    TraceReader trace;
+    if(!trace.Open(filePath.c_str())){
+        fprintf(stderr, "ERROR: Instruction file path could not be opened (%s)\n", filePath.c_str());
+        out.Flush();
+        exit(1);
+    }
+    TraceCommand cmd;
+    while(trace.Next(cmd))
+    {
+        RunCommand(cmd);
+    }
+}
+//--
+void LotteryScheduler::RunInstructionString(std::string_view line)
+{
+    TraceCommand cmd;
+    if(ParseTraceLine(line, cmd))
+    {
+        RunCommand(cmd);
+    }
+}
+//--
+/*
+Given an instruction already parsed by the trace parser, run the desired instruction
+
+Instruct List
+    opcode	    argument 1  argument 2  meaning
+    newjob	    NAME	    TICKETS 	A new job holding TICKETS lottery tickets has arrived
+    finish			                    The currently running job has terminated - it is an error if the system is idle
+    interrupt			                A timer interrupt has occurred - a new lottery is held
+    block			                    The currently running job has become blocked
+    unblock	    NAME		            The named job becomes unblocked - it is an error if it was not blocked
+    runnable			                Print information about the jobs in the runnable queue
+    running			                    Print information about the currently running job
+    blocked			                    Print information about the jobs on the blocked queue
+
+    setpri, group, checkpoint, restore, transfer, time are stride only: they are reported as errors
+*/
+void LotteryScheduler::RunCommand(const TraceCommand& cmd)
+{
+    stats.instructions++;
+    switch (cmd.opcode)
+    {
+        case NEWJOB:
+        {
+            CreateNewJob(cmd.arg1, cmd.arg2);
+            break;
+        }
+        case INTERRUPT:
+        {
+            Interrupt();
+            break;
+        }
+        case BLOCK:
+        {
+            Block();
+            break;
+        }
+        case UNBLOCK:
+        {
+            UnBlock(cmd.arg1);
+            break;
+        }
+        case FINISH:
+        {
+            FinishJob();
+            break;
+        }
+        case RUNNING:
+        {
+            PrintRunningTask();
+            break;
+        }
+        case RUNNABLE:
+        {
+            PrintRunnables();
+            break;
+        }
+        case BLOCKED:
+        {
+            PrintBlockedTasks();
+            break;
+        }
+        case SETPRI:
+        case GROUP:
+        case CHECKPOINT:
+        case RESTORE:
+        case TRANSFER:
+        case TIME:
+        {
+            // Stride only, a trace relying on them would silently give different results here
+            stats.errors++;
+            fprintf(stderr, "ERROR: Instruction not supported by the lottery policy:%s\n", OpcodeName(cmd.opcode));
+            break;
+        }
+        case INVALID:
+        default:
+        {
+            break;
+        }
+    }
+}
+//--
+void LotteryScheduler::SetVerbose(const bool& on)
+{
+    verbose = on;
+}
+//--
+/*
+    Send the output into text rather than stdout (nullptr goes back to stdout), as Scheduler::CaptureOutput does
+*/
+void LotteryScheduler::CaptureOutput(std::string* text)
+{
+    out.CaptureTo(text);
+}
+//--
+void LotteryScheduler::FlushOutput()
+{
+    out.Flush();
+}
+//--
+void LotteryScheduler::PrintSummary()
+{
+    stats.Print(out, idleJobs.size(), (currRunningJob != nullptr) ? 1 : 0, blockedJobs.size());
+    out.Flush();
+}
+//--
+/*
+    Print the response, turnaround & blocked time percentiles, in ticks of the simulated clock
+    Same table as Scheduler::PrintLatency
+*/
+void LotteryScheduler::PrintLatency()
+{
+    out.Write("Latency (ticks):\n");
+    out.Write(Column("", 12), Column("COUNT", 10), Column("P50", 10), Column("P99", 10), Column("P999", 10), "MAX\n");
+    const char* names[] = {"Response", "Turnaround", "Blocked"};
+    const LatencyHistogram* histograms[] = {&responseTimes, &turnaroundTimes, &blockedTimes};
+    for(int i = 0; i < 3; i++)
+    {
+        const LatencyHistogram& h = *histograms[i];
+        out.Write(Column(names[i], 12), Column(h.Count(), 10), Column(h.Percentile(0.5), 10),
+                  Column(h.Percentile(0.99), 10), Column(h.Percentile(0.999), 10), h.Max(), '\n');
+    }
+    out.Flush();
+}
+//--
+/*
+    Hold on to each finished job's fairness numbers for ExportFairness
+*/
+void LotteryScheduler::KeepFinishedJobs(const bool& on)
+{
+    keepFinished = on;
+}
+//--
+/*
+    Write the per job fairness & latency numbers to a file, in Scheduler::ExportFairness's format
+    There are no groups, so the group column is left empty
+*/
+bool LotteryScheduler::ExportFairness(const std::string& filePath)
+{
+    FairnessExporter exporter;
+    if(!exporter.Open(filePath))
+    {
+        fprintf(stderr, "ERROR: Fairness file could not be opened (%s)\n", filePath.c_str());
+        return false;
+    }
+    for(FairnessResult& result : finishedFairness)
+    {
+        exporter.Write(result.name, result.group, "finished", result.record, result.ideal);
+    }
+    if(currRunningJob != nullptr)
+    {
+        fairness.SampleLag(currRunningJob->fairness);
+        exporter.Write(currRunningJob->name, "", "running", currRunningJob->fairness, fairness.Ideal(currRunningJob->fairness));
+    }
+    for(map<string, Job*, less<>>::iterator it = idleJobs.begin(); it != idleJobs.end(); it++)
+    {
+        Job* job = it->second;
+        fairness.SampleLag(job->fairness); // A waiting job's lag may still be climbing
+        exporter.Write(job->name, "", "runnable", job->fairness, fairness.Ideal(job->fairness));
+    }
+    for(map<string, Job*, less<>>::iterator it = blockedJobs.begin(); it != blockedJobs.end(); it++)
+    {
+        Job* job = it->second;
+        exporter.Write(job->name, "", "blocked", job->fairness, fairness.Ideal(job->fairness));
+    }
+    return true;
+}
+//--
+/*
+    Hold a lottery among every job holding tickets (runnable or running)
+    Returns nullptr if nobody holds any tickets
+*/
+LotteryScheduler::Job* LotteryScheduler::DrawWinner()
+{
+    uint64_t total = tickets.Total();
+    if(total == 0)
+    {
+        return nullptr;
+    }
+    // Reject the top sliver of values that would bias the modulo
+    uint64_t limit = UINT64_MAX - (UINT64_MAX % total);
+    uint64_t draw;
+    do
+    {
+        draw = rng.Next();
+    } while(draw >= limit);
+
+    return slotJobs[tickets.Find(draw % total)];
+}
+//--
+/*
+    Give the job a slot in the ticket tree, reusing a finished job's slot if we can
+    The tree doubles in size when it runs out of slots
+*/
+size_t LotteryScheduler::AllocateSlot(Job* job)
+{
+    size_t slot;
+    if(freeSlots.size() > 0)
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+        slotJobs[slot] = job;
+    }
+    else
+    {
+        slot = slotJobs.size();
+        slotJobs.push_back(job);
+        if(slot >= tickets.Size())
+        {
+            tickets.Resize(tickets.Size() > 0 ? tickets.Size() * 2 : 16);
+        }
+    }
+    return slot;
+}
+//--
+/*
+    OPCODE: newjob
+    MEANING: A new job with specified TICKETS and NAME has arrived
+
+    A new job's arrival does not cause a rescheduling unless the system was idle.
+*/
+void LotteryScheduler::CreateNewJob(string_view name, const int& numTickets)
+{
+    if(numTickets < 1)
+    {
+        stats.errors++;
+        Report("Error. Job: ", name, " needs at least one ticket.\n");
+        return;
+    }
+    Job* nJob = new Job(name, numTickets, 0, clock);
+    nJob->slot = AllocateSlot(nJob);
+    tickets.Set(nJob->slot, numTickets);
+    idleJobs[nJob->name] = nJob;
+    fairness.Activate(nJob->fairness, numTickets, clock);
+    stats.newJobs++;
+    Report("New job: ", nJob->name, " added with tickets: ", numTickets, '\n');
+
+    if(!systemRunning)
+    {
+        Reschedule();
+    }
+}
+//--
+/*
+    OPCODE: finish
+    MEANING:    The currently running job has completed and should be removed from the system.
+                If the system is idle, it is an error.
+*/
+void LotteryScheduler::FinishJob()
+{
+    if(systemRunning)
+    {
+        stats.completed++;
+        Report("Job: ", currRunningJob->name, " completed.\n");
+        fairness.Deactivate(currRunningJob->fairness);
+        turnaroundTimes.Record(clock - currRunningJob->arrival);
+        blockedTimes.Record(currRunningJob->blockedTotal);
+        if(keepFinished)
+        {
+            finishedFairness.push_back(FairnessResult{currRunningJob->name, "", currRunningJob->fairness,
+                                                      fairness.Ideal(currRunningJob->fairness)});
+        }
+        tickets.Set(currRunningJob->slot, 0);
+        slotJobs[currRunningJob->slot] = nullptr;
+        freeSlots.push_back(currRunningJob->slot);
+        delete currRunningJob;
+        currRunningJob = nullptr;
+        Reschedule();
+    }
+    else
+    {
+        stats.errors++;
+        Report("Error. System is idle.\n");
+    }
+}
+//--
+/*
+    Hold a lottery and run the winner
+    The job that was running stays in the draw, so it may well win again
+*/
+void LotteryScheduler::Reschedule()
+{
+    Job* winner = DrawWinner();
+    if(winner != nullptr)
+    {
+        if(winner != currRunningJob)
+        {
+            if(currRunningJob != nullptr)
+            {
+                // Swap the old job back into the idle jobs
+                idleJobs[currRunningJob->name] = currRunningJob;
+                fairness.Descheduled(currRunningJob->fairness, clock);
+            }
+            idleJobs.erase(winner->name);
+            fairness.Scheduled(winner->fairness, clock);
+            if(!winner->started)
+            {
+                winner->started = true;
+                responseTimes.Record(clock - winner->arrival);
+            }
+            currRunningJob = winner;
+        }
+        systemRunning = true;
+        winner->wins++;
+        stats.schedules++;
+        Report("Job: ", winner->name, " scheduled.\n");
+    }
+    else
+    {
+        stats.idles++;
+        Report("System is idle.\n");
+        systemRunning = false;
+    }
+}
+//--
+/*
+    OPCODE: interrupt
+    MEANING:    The currently running task has completed its quantum, hold a new lottery.
+    It is an error if 'interrupt' is received when the system is idle.
+*/
+void LotteryScheduler::Interrupt()
+{
+    if(systemRunning)
+    {
+        stats.interrupts++;
+        clock++;
+        if(currRunningJob != nullptr)
+        {
+            fairness.Quantum(currRunningJob->fairness);
+        }
+        Reschedule();
+    }
+    else
+    {
+        stats.errors++;
+        Report("Error. System is idle.\n");
+    }
+}
+//--
+/*
+    OPCODE: block
+    MEANING: The currently running task has become blocked, its tickets leave the draw.
+    It is an error if the system is idle.
+*/
+void LotteryScheduler::Block()
+{
+    if(systemRunning)
+    {
+        Job* bljb = currRunningJob;
+        tickets.Set(bljb->slot, 0);
+        blockedJobs[bljb->name] = bljb;
+        fairness.Blocked(bljb->fairness);
+        bljb->blockedSince = clock;
+        stats.blocks++;
+        Report("Job: ", bljb->name, " blocked.\n");
+        currRunningJob = nullptr;
+        Reschedule();
+    }
+    else
+    {
+        stats.errors++;
+        Report("Error. System is idle.\n");
+    }
+}
+//--
+/*
+    OPCODE: unblock
+    SYNTAX: unblock,A
+    MEANING: The named job has become unblocked, its tickets rejoin the draw.
+
+    It is an error if the named job was not blocked.
+    The scheduler is not run unless the system was idle.
+*/
+void LotteryScheduler::UnBlock(string_view name)
+{
+    map<string, Job*, less<>>::iterator blIt = blockedJobs.find(name);
+    if(blIt != blockedJobs.end())
+    {
+        Job* unblockedJob = blIt->second;
+        blockedJobs.erase(blIt);
+
+        idleJobs[unblockedJob->name] = unblockedJob;
+        tickets.Set(unblockedJob->slot, unblockedJob->tickets);
+        fairness.Activate(unblockedJob->fairness, unblockedJob->tickets, clock);
+        unblockedJob->blockedTotal += clock - unblockedJob->blockedSince;
+        stats.unblocks++;
+        Report("Job: ", unblockedJob->name, " has unblocked.\n");
+        if(!systemRunning)
+        {
+            Reschedule();
+        }
+    }
+    else
+    {
+        stats.errors++;
+        Report("Error. Job: ", name, " not blocked.\n");
+    }
+}
+//--
+/*
+    Print one row of a job listing
+    Matches the "NAME    TICKETS WINS" heading
+*/
+void LotteryScheduler::PrintJob(const Job* job)
+{
+    Report(Column(job->name, 8), Column(job->tickets, 8), Column(job->wins, 6), '\n');
+}
+//--
+/*
+    OPCODE: runnable
+    MEANING: The runnables, if any, are listed by name.
+    There is no schedule order to list them in - the next lottery decides.
+*/
+void LotteryScheduler::PrintRunnables()
+{
+    Report("Runnable:\n");
+    if(idleJobs.size() > 0)
+    {
+        Report("NAME    TICKETS WINS\n");
+        for(map<string, Job*, less<>>::iterator it = idleJobs.begin(); it != idleJobs.end(); it++)
+        {
+            PrintJob(it->second);
+        }
+    }
+    else
+    {
+        Report("None\n");
+    }
+}
+//--
+/*
+    OPCODE: running
+    MEANING:    The running task is described (if system is not idle).
+*/
+void LotteryScheduler::PrintRunningTask()
+{
+    Report("Running:\n");
+    if(currRunningJob != nullptr)
+    {
+        Report("NAME    TICKETS WINS\n");
+        PrintJob(currRunningJob);
+    }
+    else
+    {
+        Report("None\n");
+    }
+}
+//--
+/*
+    OPCODE: blocked
+    MEANING: The blocked tasks are listed, if any.
+*/
+void LotteryScheduler::PrintBlockedTasks()
+{
+    Report("Blocked:\n");
+    if(blockedJobs.size() > 0)
+    {
+        Report("NAME    TICKETS WINS\n");
+        for(map<string, Job*, less<>>::iterator it = blockedJobs.begin(); it != blockedJobs.end(); it++)
+        {
+            PrintJob(it->second);
+        }
+    }
+    else
+    {
+        Report("None\n");
+    }
+}
+//--
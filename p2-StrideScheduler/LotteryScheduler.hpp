@@ -0,0 +1,103 @@
+#pragma once
+#include <stdio.h>
+#include <string>
+#include <string_view>
+#include <map>
+#include <vector>
+#include "TraceParser.hpp"
+#include "OutputSink.hpp"
+#include "SchedulerStats.hpp"
+#include "FenwickTree.hpp"
+#include "Random.hpp"
+#include "Fairness.hpp"
+#include "LatencyHistogram.hpp"
+
+/*
+    Lottery scheduling, driven by the same trace language as Scheduler
+    A job's priority is its number of tickets.
+
+    Every runnable (or running) job holds its tickets in a Fenwick tree,
+    so each draw costs O(log n) no matter how many jobs are in the system.
+    Draws come from a seeded PRNG, so a given seed always replays the same schedule.
+
+    The fairness & latency numbers are kept exactly as Scheduler keeps them
+    (one clock tick & one quantum per interrupt), so the two policies can be compared on the same trace.
+*/
+class LotteryScheduler{
+public:
+    LotteryScheduler(const uint64_t& seed = 1);
+    ~LotteryScheduler();
+    void RunInstructionFile(const std::string& filePath);
+    void RunInstructionString(std::string_view line);
+    void RunCommand(const TraceCommand& cmd);
+    void SetVerbose(const bool& on);
+    void CaptureOutput(std::string* text);
+    void FlushOutput();
+    void PrintSummary();
+    void PrintLatency();
+    void KeepFinishedJobs(const bool& on);
+    bool ExportFairness(const std::string& filePath);
+private:
+
+    struct Job{
+        Job(std::string_view n, int t, size_t s, uint64_t now) : name(n), tickets(t), slot(s), wins(0),
+            arrival(now), blockedSince(0), blockedTotal(0), started(false) {}
+
+        std::string name;
+        int tickets;
+        size_t slot;    // Position in the ticket tree
+        uint64_t wins;  // Number of lotteries won
+        FairnessRecord fairness;
+        // Simulated clock readings, for the latency histograms
+        uint64_t arrival;
+        uint64_t blockedSince;
+        uint64_t blockedTotal;
+        bool started; // Has run at least once
+    };
+
+    // Methods
+    Job* DrawWinner();
+    size_t AllocateSlot(Job* job);
+    void CreateNewJob(std::string_view name, const int &tickets);
+    void Reschedule();
+
+    void FinishJob();
+    void Interrupt();
+    void Block();
+    void UnBlock(std::string_view name);
+    void PrintRunnables();
+    void PrintRunningTask();
+    void PrintBlockedTasks();
+    void PrintJob(const Job* job);
+
+    // Per event output, dropped entirely when not verbose
+    template <typename... Args>
+    void Report(const Args&... args)
+    {
+        if(verbose)
+        {
+            out.Write(args...);
+        }
+    }
+
+    // Data Members
+    std::map<std::string, Job*, std::less<>> idleJobs;
+    std::map<std::string, Job*, std::less<>> blockedJobs;
+    std::vector<Job*> slotJobs;     // Slot -> Job, nullptr when free
+    std::vector<size_t> freeSlots;  // Slots of finished jobs, reused first
+    FenwickTree tickets;            // Runnable & running jobs hold their tickets here, blocked jobs hold 0
+    SplitMix64 rng;
+    Job* currRunningJob;
+    bool systemRunning;
+    bool verbose;
+    SchedulerStats stats;
+    OutputSink out;
+
+    uint64_t clock; // Simulated time: one tick per interrupt
+    LatencyHistogram responseTimes;     // Arrival to first run
+    LatencyHistogram turnaroundTimes;   // Arrival to finish
+    LatencyHistogram blockedTimes;      // Time spent blocked over a job's whole life, recorded at finish
+    FairnessTracker fairness;
+    bool keepFinished; // Only worth the memory when the numbers will be exported
+    std::vector<FairnessResult> finishedFairness; // Final numbers of jobs that have completed
+};
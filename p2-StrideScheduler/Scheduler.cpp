@@ -6,50 +6,72 @@ Scheduler::Scheduler()
 {
     systemRunning = false;
     currRunningJob = nullptr;
+    verbose = true;
+    keepFinished = false;
+    blockedOrder = BLOCKED_BY_NAME;
+    idleCount = 0;
+    clock = 0;
+    // Jobs that don't name a group share this one
+    groups[DEFAULT_GROUP] = new Group(DEFAULT_GROUP, DEFAULT_GROUP_TICKETS);
 }
 //--
 Scheduler::~Scheduler()
+{
+    DeleteEverything();
+}
+//--
+/*
+    Delete every job and group in the system, leaving it empty (not even the default group)
+*/
+void Scheduler::DeleteEverything()
 {
     // Incase we have
     if(currRunningJob != nullptr)
     {
-        delete currRunningJob;
+        jobPool.Delete(currRunningJob);
         currRunningJob = nullptr;
     }
     // Incase we have idle jobs waiting to be deleted
-    for(map<string, Job*>::iterator it = idleJobs.begin(); it != idleJobs.end(); it++)
+    // Each group owns the idle jobs in its runnables
+    for(map<string, Group*, less<>>::iterator it = groups.begin(); it != groups.end(); it++)
     {
+        for(Job* job : it->second->runnables)
+        {
+            jobPool.Delete(job);
+        }
         delete it->second;
     }
     // Incase we have blocked jobs waiting to be deleted
-    for(map<string, Job*>::iterator it = blockedJobs.begin(); it != blockedJobs.end(); it++)
+    while(blockedJobs.size() > 0)
     {
-        delete it->second;
+        jobPool.Delete(blockedJobs.PopFront());
     }
+    groups.clear();
+    runnableGroups.clear();
+    jobIndex.clear();
+    idleCount = 0;
+    systemRunning = false;
 }
 //--
 /*
-    Read in the file via the path specified
+    Map in the file via the path specified
     And execute the instruction found on each line
 */
-void Scheduler::RunInstructionFile(const std::string filePath)
+void Scheduler::RunInstructionFile(const std::string& filePath)
 {
-    ifstream FIN(filePath);
-    if(!FIN.is_open()){
+    TraceReader trace;
+    if(!trace.Open(filePath.c_str())){
         fprintf(stderr, "ERROR: Instruction file path could not be opened (%s)\n", filePath.c_str());
+        out.Flush();
         exit(1);
     }
-    // File opened successfully
-    string line;
-    // Read each line from the file
-    while(getline(FIN, line))
+    // File mapped successfully
+    TraceCommand cmd;
+    // Run each (non-blank) line from the file
+    while(trace.Next(cmd))
     {
-        if(line != "" && line != "\n" && line != "\r")
-        {
-            RunInstructionString(line);
-        }
+        RunCommand(cmd);
     }
-    FIN.close();
 }
 //--
 /* 
@@ -57,135 +79,28 @@ void Scheduler::RunInstructionFile(const std::string filePath)
     Separate the string into the appropriate details and use it
     to call RunCommand
  */
-void Scheduler::RunInstructionString(std::string line)
+void Scheduler::RunInstructionString(std::string_view line)
 {
-    string opcode;
-    string arg1;
-    int arg2 = -1;
-
-    size_t cIndex = line.find(',');
-    if(cIndex != string::npos)
-    {
-        // Comma found
-        opcode = line.substr(0, cIndex);
-        line.erase(0, cIndex+1); // Erase up to (AND INCLUDING) first comma
-
-         // More to the line exists
-        if(line.size() > 0)
-        {
-            cIndex = line.find(','); // Find next comma
-            if(cIndex != string::npos)
-            {
-                // Comma found
-                arg1 = line.substr(0, cIndex); // Take up to that as the arg1
-                line.erase(0, cIndex+1); // Erase up to next comma
-                if(line.size() > 0)
-                {
-                    arg2 = stoi(line);
-                }
-            }
-            else
-            {
-                arg1 = line;
-            }
-        }
-    }
-    else
-    {
-        // Comma not found
-        opcode = line;
-    }
-    RunCommand(opcode, arg1, arg2);
-}
-//--
-/* 
-    Parses the given opcode and any potential arguments
-Args:
-    const string opcode --> The string representation of an instruction
-
-Return:
-    OPCODE --> The supplied opcode argument transformed into the proper ENUM
-*/
-OPCODE Scheduler::ParseCode(const string opcode)
-{
-    // Using the first letter of the opcode, 
-    // we can go through a switch statement to determine the proper value
-    switch (opcode.at(0))
-    {
-    case 'n':
-    {
-        if (opcode == "newjob")
-        {
-            return NEWJOB;
-        }
-        break;
-    }
-
-    case 'f':
-    {
-        if (opcode == "finish")
-        {
-            return FINISH;
-        }
-        break;
-    }
-
-    case 'i':
-    {
-        if (opcode == "interrupt")
-        {
-            return INTERRUPT;
-        }
-        break;
-    }
-
-    case 'b':
-    {
-        if (opcode == "block")
-        {
-            return BLOCK;
-        }
-        else if (opcode == "blocked")
-        {
-            return BLOCKED;
-        }
-        break;
-    }
-    case 'u':
+    TraceCommand cmd;
+    if(ParseTraceLine(line, cmd))
     {
-        if (opcode == "unblock")
-        {
-            return UNBLOCK;
-        }
-        break;
+        RunCommand(cmd);
     }
-    case 'r':
-    {
-        if (opcode == "running")
-        {
-            return RUNNING;
-        }
-        else if (opcode == "runnable")
-        {
-            return RUNNABLE;
-        }
-        break;
-    }
-    default:
-    {
-        break;
-    }
-    }
-    fprintf(stderr, "ERROR: Invalid instruction found:%s\n", opcode.c_str());
-    return INVALID;
 }
 //--
 /*
-Given the read in instruction & arguments, convert the instruction using ParseCode and run the desired instruction
+Given an instruction already parsed by the trace parser, run the desired instruction
 
 Instruct List
     opcode	    argument 1  argument 2  meaning
     newjob	    NAME	    PRIORITY	A new job with specified PRIORITY and NAME has arrived
+                                        (an optional 3rd argument names the job's GROUP)
+    group       NAME        TICKETS     Create a group (tenant) holding TICKETS, or change an existing group's TICKETS
+    checkpoint  FILE                    Save every group & job (runnable, running, blocked) to a binary snapshot
+    restore     FILE                    Replace everything in the system with a snapshot saved by checkpoint
+    setpri      NAME        PRIORITY    Change the named job's PRIORITY (running, runnable or blocked)
+    transfer    FROM        TO          Move N tickets (a 3rd argument) of priority from job FROM to job TO
+    time        T                       The simulated clock moves forward to T (it also ticks once per interrupt)
     finish			                    The currently running job has terminated - it is an error if the system is idle
     interrupt			                A timer interrupt has occurred - the currently running job's quantum is over
     block			                    The currently running job has become blocked
@@ -194,14 +109,14 @@ Instruct List
     running			                    Print information about the currently running job
     blocked			                    Print information about the jobs on the blocked queue
 */
-void Scheduler::RunCommand(const string &opcode, const string &arg1 = "", const int &arg2 = -1)
+void Scheduler::RunCommand(const TraceCommand& cmd)
 {
-    OPCODE oCode = ParseCode(opcode);
-    switch (oCode)
+    stats.instructions++;
+    switch (cmd.opcode)
     {
         case NEWJOB:
         {
-            CreateNewJob(arg1, arg2);
+            CreateNewJob(cmd.arg1, cmd.arg2, cmd.arg3);
             break;
         }
         case INTERRUPT:
@@ -216,7 +131,7 @@ void Scheduler::RunCommand(const string &opcode, const string &arg1 = "", const
         }
         case UNBLOCK:
         {
-            UnBlock(arg1);
+            UnBlock(cmd.arg1);
             break;
         }
         case FINISH:
@@ -239,6 +154,36 @@ void Scheduler::RunCommand(const string &opcode, const string &arg1 = "", const
             PrintBlockedTasks();
             break;
         }
+        case GROUP:
+        {
+            CreateGroup(cmd.arg1, cmd.arg2);
+            break;
+        }
+        case CHECKPOINT:
+        {
+            Checkpoint(cmd.arg1);
+            break;
+        }
+        case RESTORE:
+        {
+            Restore(cmd.arg1);
+            break;
+        }
+        case SETPRI:
+        {
+            SetPriority(cmd.arg1, cmd.arg2);
+            break;
+        }
+        case TRANSFER:
+        {
+            Transfer(cmd.arg1, cmd.arg2Text, cmd.arg3);
+            break;
+        }
+        case TIME:
+        {
+            AdvanceClock(cmd.arg1);
+            break;
+        }
         case INVALID:
         default:
         {
@@ -248,62 +193,546 @@ void Scheduler::RunCommand(const string &opcode, const string &arg1 = "", const
 }
 //--
 /*
-    Used to sort our jobs alphebetically
-    Used when we are scheduling ties
+    Turn the per event output on or off
+    When off, only the summary statistics are worth printing
 */
-bool Scheduler::CompareJobsByName(Job* job1, Job* job2)
+void Scheduler::SetVerbose(const bool& on)
 {
-    return (job1->name < job2->name);
+    verbose = on;
 }
 //--
 /*
-    Used to sort our jobs by pass value
-    Used when we are printing our runnables
+    Pick the order the blocked command lists the blocked jobs in
 */
-bool Scheduler::CompareJobsByPass(Job* job1, Job* job2)
+void Scheduler::SetBlockedOrder(const BLOCKED_ORDER& order)
 {
-    return (job1->pass < job2->pass);
+    blockedOrder = order;
 }
 //--
 /*
-    Go through each of the idle jobs and return whichever Job has the lowest pass
-    If we have a tie, take whichever is first alphebetically by name 
+    Send this scheduler's output into text rather than stdout (nullptr goes back to stdout)
+    Lets several schedulers run side by side in one process, i.e. the regression runner
 */
-Scheduler::Job* Scheduler::GrabMinPassJob()
+void Scheduler::CaptureOutput(std::string* text)
 {
-    list<Job*> lowestJobs;
-
-    if(idleJobs.size() > 0)
+    out.CaptureTo(text);
+}
+//--
+/*
+    Push out whatever output is still buffered
+*/
+void Scheduler::FlushOutput()
+{
+    out.Flush();
+}
+//--
+const SchedulerStats& Scheduler::Stats() const
+{
+    return stats;
+}
+//--
+/*
+    Print the aggregate statistics gathered over the whole run
+*/
+void Scheduler::PrintSummary()
+{
+    stats.Print(out, idleCount, (currRunningJob != nullptr) ? 1 : 0, blockedJobs.size());
+    out.Flush();
+}
+//--
+/*
+    Print the response, turnaround & blocked time percentiles, in ticks of the simulated clock
+    Only jobs that have run (response) or finished (turnaround, blocked) are counted
+*/
+void Scheduler::PrintLatency()
+{
+    out.Write("Latency (ticks):\n");
+    out.Write(Column("", 12), Column("COUNT", 10), Column("P50", 10), Column("P99", 10), Column("P999", 10), "MAX\n");
+    const char* names[] = {"Response", "Turnaround", "Blocked"};
+    const LatencyHistogram* histograms[] = {&responseTimes, &turnaroundTimes, &blockedTimes};
+    for(int i = 0; i < 3; i++)
     {
-        int lowestPassVal = INT_MAX;
-        for(map<string, Job*>::iterator it = idleJobs.begin(); it != idleJobs.end(); it++)
+        const LatencyHistogram& h = *histograms[i];
+        out.Write(Column(names[i], 12), Column(h.Count(), 10), Column(h.Percentile(0.5), 10),
+                  Column(h.Percentile(0.99), 10), Column(h.Percentile(0.999), 10), h.Max(), '\n');
+    }
+    out.Flush();
+}
+//--
+/*
+    OPCODE: time
+    SYNTAX: time,120
+    MEANING: The simulated clock moves forward to the time given.
+    It is an error for the time not to be a plain number, or for time to go backwards.
+*/
+void Scheduler::AdvanceClock(string_view time)
+{
+    uint64_t target = 0;
+    from_chars_result result = from_chars(time.data(), time.data() + time.size(), target);
+    if(result.ec != errc() || result.ptr != time.data() + time.size())
+    {
+        stats.errors++;
+        Report("Error. Time: ", time, " is not a valid time.\n");
+        return;
+    }
+    if(target < clock)
+    {
+        stats.errors++;
+        Report("Error. Time: ", time, " is before the current time: ", clock, ".\n");
+        return;
+    }
+    clock = target;
+}
+//--
+/*
+    Name of the job currently running, empty if the system is idle
+*/
+string_view Scheduler::RunningJobName() const
+{
+    return (currRunningJob != nullptr) ? string_view(currRunningJob->name) : string_view();
+}
+//--
+/*
+    Hold on to each finished job's fairness numbers for ExportFairness
+    Off by default, so churning through millions of jobs doesn't pile up a record for each
+*/
+void Scheduler::KeepFinishedJobs(const bool& on)
+{
+    keepFinished = on;
+}
+//--
+/*
+    Write the per job fairness & latency numbers to a file (CSV, or JSON for a .json path)
+    Completed jobs come first, followed by whatever is still in the system
+*/
+bool Scheduler::ExportFairness(const std::string& filePath)
+{
+    FairnessExporter exporter;
+    if(!exporter.Open(filePath))
+    {
+        fprintf(stderr, "ERROR: Fairness file could not be opened (%s)\n", filePath.c_str());
+        return false;
+    }
+    for(FairnessResult& result : finishedFairness)
+    {
+        exporter.Write(result.name, result.group, "finished", result.record, result.ideal);
+    }
+    if(currRunningJob != nullptr)
+    {
+        fairness.SampleLag(currRunningJob->fairness);
+        exporter.Write(currRunningJob->name, currRunningJob->group->name, "running",
+                       currRunningJob->fairness, fairness.Ideal(currRunningJob->fairness));
+    }
+    for(Group* group : runnableGroups)
+    {
+        for(Job* job : group->runnables)
         {
-            if(it->second->pass <= lowestPassVal)
-            {
-                if(it->second->pass < lowestPassVal)
-                {
-                    // Current Job we are looking at has a lower pass val
-                    lowestJobs.clear();
-                    lowestJobs.push_back(it->second);
-                    lowestPassVal = it->second->pass; // Keep track of our lowest value so far
-                }
-                else
-                {
-                    // Pass value of iterated job is equal to the lowest
-                    lowestJobs.push_back(it->second);
-                }
-            }
+            fairness.SampleLag(job->fairness); // A waiting job's lag may still be climbing
+            exporter.Write(job->name, group->name, "runnable", job->fairness, fairness.Ideal(job->fairness));
         }
-        if(lowestJobs.size() > 1)
+    }
+    for(Job* job : blockedJobs)
+    {
+        exporter.Write(job->name, job->group->name, "blocked", job->fairness, fairness.Ideal(job->fairness));
+    }
+    return true;
+}
+//--
+/*
+    Print one row of a job listing
+    Matches the "NAME    STRIDE  PASS  PRI" heading
+*/
+void Scheduler::PrintJob(const Job* job)
+{
+    Report(Column(job->name, 8), Column(job->stride, 8), Column(job->pass, 6), Column(job->priority, 6), '\n');
+}
+//--
+/*
+    Pick the lowest pass group, then the lowest pass job inside that group
+    (ties go to whichever is first alphebetically by name)
+    The job is taken out of the idle jobs, each level costs O(log n)
+*/
+Scheduler::Job* Scheduler::GrabMinPassJob()
+{
+    if(runnableGroups.size() > 0)
+    {
+        Group* group = *runnableGroups.begin();
+        Job* job = *group->runnables.begin();
+        group->runnables.erase(group->runnables.begin());
+        if(group->runnables.size() == 0)
         {
-            lowestJobs.sort(CompareJobsByName); // Sort lowest jobs alphabetically by name
+            // Nothing left in the group to schedule
+            runnableGroups.erase(runnableGroups.begin());
         }
-        return lowestJobs.front(); // Return the first job alphabetically
+        idleCount--;
+        return job;
     }
     // Nothing in our idle list to consider
     return nullptr;
 }
 //--
+/*
+    Place a job back among the idle jobs of its group
+    A group with its first idle job becomes schedulable
+*/
+void Scheduler::MakeRunnable(Job* job)
+{
+    Group* group = job->group;
+    if(group->runnables.size() == 0)
+    {
+        runnableGroups.insert(group);
+    }
+    group->runnables.insert(job);
+    idleCount++;
+}
+//--
+/*
+    Charge a group for one quantum used by one of its jobs
+    The group is re-keyed if it is currently waiting to be scheduled
+*/
+void Scheduler::AdvanceGroup(Group* group)
+{
+    bool queued = group->runnables.size() > 0;
+    if(queued)
+    {
+        runnableGroups.erase(group);
+    }
+    group->pass += group->stride;
+    if(queued)
+    {
+        runnableGroups.insert(group);
+    }
+}
+//--
+/*
+    Shift the passes of a group's jobs back down, so the lowest competing (idle or running) one is 0
+
+    Only differences between passes matter to the schedule, and every competing job moves by the same amount,
+    so the runnables keep their order and can be updated in place. O(n), but only once every PASS_RENORMALIZE_AT.
+    NOTE: a blocked job that has fallen further behind than that is brought up to 0,
+    it keeps its place at the front of the line but can no longer hog the CPU for ages when it unblocks.
+*/
+void Scheduler::RenormalizeJobs(Group* group)
+{
+    uint64_t base;
+    if(currRunningJob != nullptr && currRunningJob->group == group)
+    {
+        base = currRunningJob->pass;
+    }
+    else if(group->runnables.size() > 0)
+    {
+        base = (*group->runnables.begin())->pass;
+    }
+    else
+    {
+        // Nothing competing, nothing to measure from
+        return;
+    }
+    if(group->runnables.size() > 0 && PassBefore((*group->runnables.begin())->pass, base))
+    {
+        base = (*group->runnables.begin())->pass;
+    }
+
+    for(Job* job : group->runnables)
+    {
+        job->pass -= base;
+    }
+    if(currRunningJob != nullptr && currRunningJob->group == group)
+    {
+        currRunningJob->pass -= base;
+    }
+    for(Job* job : blockedJobs)
+    {
+        if(job->group == group)
+        {
+            job->pass = PassBefore(job->pass, base) ? 0 : job->pass - base;
+        }
+    }
+}
+//--
+/*
+    The same as RenormalizeJobs, one level up
+    The groups competing are the runnable groups and the running job's group,
+    and a group with nothing competing that has fallen behind them is brought up to 0
+*/
+void Scheduler::RenormalizeGroups()
+{
+    uint64_t base;
+    if(currRunningJob != nullptr)
+    {
+        base = currRunningJob->group->pass;
+    }
+    else if(runnableGroups.size() > 0)
+    {
+        base = (*runnableGroups.begin())->pass;
+    }
+    else
+    {
+        return;
+    }
+    if(runnableGroups.size() > 0 && PassBefore((*runnableGroups.begin())->pass, base))
+    {
+        base = (*runnableGroups.begin())->pass;
+    }
+
+    for(map<string, Group*, less<>>::iterator it = groups.begin(); it != groups.end(); it++)
+    {
+        Group* group = it->second;
+        bool competing = group->runnables.size() > 0 || (currRunningJob != nullptr && currRunningJob->group == group);
+        if(competing || !PassBefore(group->pass, base))
+        {
+            group->pass -= base;
+        }
+        else
+        {
+            group->pass = 0;
+        }
+    }
+}
+//--
+/*
+    Look up a group by name, nullptr if there isn't one
+*/
+Scheduler::Group* Scheduler::FindGroup(string_view name)
+{
+    map<string, Group*, less<>>::iterator it = groups.find(name);
+    return (it != groups.end()) ? it->second : nullptr;
+}
+//--
+/*
+    OPCODE: group
+    SYNTAX: group,NAME,TICKETS
+    MEANING: A group (tenant) holding TICKETS tickets is created.
+    If the group already exists, its tickets are changed instead.
+    Either way the group keeps its pass.
+*/
+void Scheduler::CreateGroup(string_view name, const int& tickets)
+{
+    if(tickets < 1)
+    {
+        stats.errors++;
+        Report("Error. Group: ", name, " needs at least one ticket.\n");
+        return;
+    }
+    Group* group = FindGroup(name);
+    if(group == nullptr)
+    {
+        group = new Group(name, tickets);
+        groups[group->name] = group;
+        Report("New group: ", group->name, " added with tickets: ", tickets, '\n');
+    }
+    else
+    {
+        bool queued = group->runnables.size() > 0;
+        if(queued)
+        {
+            runnableGroups.erase(group);
+        }
+        group->tickets = tickets;
+        group->stride = STRIDE_PROP / tickets;
+        if(queued)
+        {
+            runnableGroups.insert(group);
+        }
+        Report("Group: ", group->name, " tickets set to: ", tickets, '\n');
+    }
+}
+//--
+/*
+    OPCODE: checkpoint
+    SYNTAX: checkpoint,FILE
+    MEANING: Save the state of the system to FILE (see Snapshot.hpp for the format).
+    Fairness numbers are not part of the snapshot.
+*/
+void Scheduler::Checkpoint(string_view filePath)
+{
+    vector<SnapshotGroup> snapGroups;
+    vector<SnapshotJob> snapJobs;
+    string names;
+    unordered_map<const Group*, uint32_t> groupIndex;
+
+    for(map<string, Group*, less<>>::iterator it = groups.begin(); it != groups.end(); it++)
+    {
+        Group* group = it->second;
+        groupIndex[group] = uint32_t(snapGroups.size());
+        snapGroups.push_back(SnapshotGroup{group->stride, group->pass, group->tickets, uint32_t(group->name.size()), names.size()});
+        names += group->name;
+    }
+    auto saveJob = [&](const Job* job, const SNAPSHOT_JOB_STATE& state)
+    {
+        snapJobs.push_back(SnapshotJob{job->stride, job->pass, job->priority, groupIndex[job->group],
+                                       state, uint32_t(job->name.size()), names.size()});
+        names += job->name;
+    };
+    if(currRunningJob != nullptr)
+    {
+        saveJob(currRunningJob, SNAP_RUNNING);
+    }
+    // In the order they would be scheduled, so restoring never has to sort
+    for(Group* group : runnableGroups)
+    {
+        for(Job* job : group->runnables)
+        {
+            saveJob(job, SNAP_RUNNABLE);
+        }
+    }
+    for(Job* job : blockedJobs)
+    {
+        saveJob(job, SNAP_BLOCKED);
+    }
+
+    SnapshotHeader header;
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.version = SNAPSHOT_VERSION;
+    header.systemRunning = systemRunning ? 1 : 0;
+    header.reserved = 0;
+    header.groupCount = snapGroups.size();
+    header.jobCount = snapJobs.size();
+    header.nameBytes = names.size();
+
+    string path(filePath);
+    FILE* fout = fopen(path.c_str(), "wb");
+    bool saved = fout != nullptr;
+    if(saved)
+    {
+        saved = fwrite(&header, sizeof(header), 1, fout) == 1;
+        saved = saved && fwrite(snapGroups.data(), sizeof(SnapshotGroup), snapGroups.size(), fout) == snapGroups.size();
+        saved = saved && fwrite(snapJobs.data(), sizeof(SnapshotJob), snapJobs.size(), fout) == snapJobs.size();
+        saved = saved && fwrite(names.data(), 1, names.size(), fout) == names.size();
+        saved = (fclose(fout) == 0) && saved;
+    }
+    if(saved)
+    {
+        Report("Checkpoint: ", filePath, " saved with ", snapJobs.size(), " jobs.\n");
+    }
+    else
+    {
+        stats.errors++;
+        Report("Error. Checkpoint: ", filePath, " could not be saved.\n");
+    }
+}
+//--
+/*
+    OPCODE: restore
+    SYNTAX: restore,FILE
+    MEANING: Throw away everything in the system and load the snapshot in FILE instead.
+    The snapshot is mapped and checked in full before anything is thrown away,
+    so a bad file leaves the system untouched.
+*/
+void Scheduler::Restore(string_view filePath)
+{
+    string path(filePath);
+    MappedFile file;
+    const SnapshotHeader* header = nullptr;
+    const SnapshotGroup* snapGroups = nullptr;
+    const SnapshotJob* snapJobs = nullptr;
+    const char* names = nullptr;
+    bool valid = file.Open(path.c_str()) && file.Size() >= sizeof(SnapshotHeader);
+    if(valid)
+    {
+        header = reinterpret_cast<const SnapshotHeader*>(file.Data());
+        valid = memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) == 0 && header->byteOrder == SNAPSHOT_BYTE_ORDER
+                && header->version == SNAPSHOT_VERSION;
+        // Guard each count on its own so the sizes below can't overflow
+        valid = valid && header->groupCount <= file.Size() && header->jobCount <= file.Size() && header->nameBytes <= file.Size();
+        valid = valid && sizeof(SnapshotHeader) + header->groupCount * sizeof(SnapshotGroup)
+                         + header->jobCount * sizeof(SnapshotJob) + header->nameBytes <= file.Size();
+    }
+    if(valid)
+    {
+        snapGroups = reinterpret_cast<const SnapshotGroup*>(file.Data() + sizeof(SnapshotHeader));
+        snapJobs = reinterpret_cast<const SnapshotJob*>(snapGroups + header->groupCount);
+        names = reinterpret_cast<const char*>(snapJobs + header->jobCount);
+        // Offset & length are checked apart so a crafted pair can't wrap round past the end of the names
+        auto nameFits = [header](const uint64_t& offset, const uint64_t& length)
+        {
+            return offset <= header->nameBytes && length <= header->nameBytes - offset;
+        };
+        unordered_set<string_view> seenNames;
+        for(uint64_t i = 0; valid && i < header->groupCount; i++)
+        {
+            const SnapshotGroup& sg = snapGroups[i];
+            valid = sg.tickets >= 1 && nameFits(sg.nameOffset, sg.nameLength)
+                    && seenNames.insert(string_view(names + sg.nameOffset, sg.nameLength)).second;
+        }
+        seenNames.clear();
+        uint64_t running = 0;
+        for(uint64_t i = 0; valid && i < header->jobCount; i++)
+        {
+            const SnapshotJob& sj = snapJobs[i];
+            running += (sj.state == SNAP_RUNNING) ? 1 : 0;
+            valid = sj.priority >= 1 && sj.group < header->groupCount && sj.state <= SNAP_BLOCKED
+                    && nameFits(sj.nameOffset, sj.nameLength)
+                    && seenNames.insert(string_view(names + sj.nameOffset, sj.nameLength)).second
+                    && running <= 1;
+        }
+        // A running system has exactly one running job, anything else would leave nothing for interrupt/block/finish to act on
+        valid = valid && (running == 1) == (header->systemRunning != 0);
+    }
+    if(!valid)
+    {
+        stats.errors++;
+        Report("Error. Checkpoint: ", filePath, " could not be restored.\n");
+        return;
+    }
+
+    // The snapshot is good, swap it in
+    DeleteEverything();
+    fairness = FairnessTracker();
+    vector<Group*> restoredGroups;
+    restoredGroups.reserve(header->groupCount);
+    for(uint64_t i = 0; i < header->groupCount; i++)
+    {
+        const SnapshotGroup& sg = snapGroups[i];
+        Group* group = new Group(string_view(names + sg.nameOffset, sg.nameLength), sg.tickets);
+        group->stride = sg.stride;
+        group->pass = sg.pass;
+        groups[group->name] = group;
+        restoredGroups.push_back(group);
+    }
+    if(FindGroup(DEFAULT_GROUP) == nullptr)
+    {
+        groups[DEFAULT_GROUP] = new Group(DEFAULT_GROUP, DEFAULT_GROUP_TICKETS);
+    }
+    for(uint64_t i = 0; i < header->jobCount; i++)
+    {
+        const SnapshotJob& sj = snapJobs[i];
+        Job* job = jobPool.New(string_view(names + sj.nameOffset, sj.nameLength), sj.priority, restoredGroups[sj.group], clock);
+        job->started = true; // Its real arrival isn't in the snapshot, so it stays out of the response times
+        job->stride = sj.stride;
+        job->pass = sj.pass;
+        jobIndex.emplace(job->name, job);
+        if(sj.state == SNAP_BLOCKED)
+        {
+            // Saved in the order they blocked, the time blocked before the checkpoint isn't in the snapshot
+            job->blocked = true;
+            job->blockedSince = clock;
+            blockedJobs.PushBack(job);
+            continue;
+        }
+        fairness.Activate(job->fairness, job->priority, clock);
+        if(sj.state == SNAP_RUNNING)
+        {
+            fairness.Scheduled(job->fairness, clock);
+            currRunningJob = job;
+        }
+        else
+        {
+            // Saved in schedule order, so each one goes on the end of its group
+            Group* group = job->group;
+            if(group->runnables.size() == 0)
+            {
+                runnableGroups.insert(group);
+            }
+            group->runnables.insert(group->runnables.end(), job);
+            idleCount++;
+        }
+    }
+    systemRunning = (currRunningJob != nullptr);
+    Report("Checkpoint: ", filePath, " restored with ", header->jobCount, " jobs.\n");
+}
+//--
 /*
     OPCODE: newjob
     MEANING: A new job with specified PRIORITY and NAME has arrived
@@ -311,12 +740,25 @@ Scheduler::Job* Scheduler::GrabMinPassJob()
     A new job is entered into the system. 
     Its name and priority are given. 
     Assume all job names are unique. 
+    An optional third argument names the group the job joins (i.e. newjob,A,10,tenant1),
+    otherwise the job joins the default group.
     A new job's arrival does not cause a rescheduling unless the system was idle.
 */
-void Scheduler::CreateNewJob(const string name, const int& priority)
+void Scheduler::CreateNewJob(string_view name, const int& priority, string_view groupName)
 {
-    idleJobs[name] = new Job(name, priority);
-    printf("New job: %s added with priority: %d\n", name.c_str(), priority);
+    Group* group = FindGroup(groupName.size() > 0 ? groupName : DEFAULT_GROUP);
+    if(group == nullptr)
+    {
+        stats.errors++;
+        Report("Error. Group: ", groupName, " does not exist.\n");
+        return;
+    }
+    Job* nJob = jobPool.New(name, priority, group, clock);
+    jobIndex.emplace(nJob->name, nJob);
+    MakeRunnable(nJob);
+    fairness.Activate(nJob->fairness, priority, clock);
+    stats.newJobs++;
+    Report("New job: ", nJob->name, " added with priority: ", priority, '\n');
 
     if(!systemRunning)
     {
@@ -324,6 +766,130 @@ void Scheduler::CreateNewJob(const string name, const int& priority)
     }
 }
 //--
+/*
+    Look up a job by name wherever it is (running, runnable or blocked), nullptr if there isn't one
+*/
+Scheduler::Job* Scheduler::FindJob(string_view name)
+{
+    unordered_map<string_view, Job*>::iterator it = jobIndex.find(name);
+    return (it != jobIndex.end()) ? it->second : nullptr;
+}
+//--
+/*
+    Give a job a new priority, and with it a new stride
+
+    The job's remaining pass (how far it is ahead of the lowest pass competing in its group)
+    is scaled by new stride / old stride, as if it had been running at the new priority all along.
+    A job that was next in line stays next in line, and a job far ahead comes back sooner (or later).
+    An idle job is taken out of its group's runnables and put back at its new pass, O(log n).
+    The running & blocked jobs aren't in any ordered structure, so they just take the new values.
+*/
+void Scheduler::Reprioritize(Job* job, const int& priority)
+{
+    Group* group = job->group;
+    set<Job*, PassOrder>::iterator it = group->runnables.find(job);
+    bool idle = it != group->runnables.end();
+    if(idle)
+    {
+        // Erase by iterator, the job's key is about to change
+        group->runnables.erase(it);
+    }
+
+    uint64_t reference = job->pass;
+    if(group->runnables.size() > 0 && PassBefore((*group->runnables.begin())->pass, reference))
+    {
+        reference = (*group->runnables.begin())->pass;
+    }
+    if(currRunningJob != nullptr && currRunningJob->group == group && PassBefore(currRunningJob->pass, reference))
+    {
+        reference = currRunningJob->pass;
+    }
+    uint64_t newStride = STRIDE_PROP / priority;
+    uint64_t remaining = job->pass - reference;
+    if(job->stride > 0)
+    {
+        remaining = remaining * newStride / job->stride;
+    }
+    job->pass = reference + remaining;
+    job->stride = newStride;
+    job->priority = priority;
+    fairness.Reweight(job->fairness, priority);
+
+    if(idle)
+    {
+        group->runnables.insert(job);
+        if(group->runnables.size() == 1)
+        {
+            // The job was the group's only idle job, so the group left the runnable groups
+            runnableGroups.insert(group);
+        }
+    }
+}
+//--
+/*
+    OPCODE: setpri
+    SYNTAX: setpri,A,50
+    MEANING: The named job's priority is changed, wherever the job is.
+    It is an error if there is no such job, or the priority is below 1.
+    The scheduler is not run, the new priority takes effect at the next interrupt.
+*/
+void Scheduler::SetPriority(string_view name, const int& priority)
+{
+    Job* job = FindJob(name);
+    if(job == nullptr)
+    {
+        stats.errors++;
+        Report("Error. Job: ", name, " does not exist.\n");
+        return;
+    }
+    if(priority < 1)
+    {
+        stats.errors++;
+        Report("Error. Job: ", name, " needs a priority of at least 1.\n");
+        return;
+    }
+    Reprioritize(job, priority);
+    stats.priorityChanges++;
+    Report("Job: ", job->name, " priority set to: ", priority, ". Pass set to: ", job->pass, '\n');
+}
+//--
+/*
+    OPCODE: transfer
+    SYNTAX: transfer,A,B,5
+    MEANING: 5 of job A's tickets (priority) are handed to job B.
+    It is an error if the amount is not a plain number, either job doesn't exist, they are the same job,
+    or A would be left with less than 1.
+*/
+void Scheduler::Transfer(string_view fromName, string_view toName, string_view amount)
+{
+    int tickets = 0;
+    from_chars_result result = from_chars(amount.data(), amount.data() + amount.size(), tickets);
+    if(result.ec != errc() || result.ptr != amount.data() + amount.size())
+    {
+        stats.errors++;
+        Report("Error. Transfer: ", amount, " is not a valid number of tickets.\n");
+        return;
+    }
+    Job* from = FindJob(fromName);
+    Job* to = FindJob(toName);
+    if(from == nullptr || to == nullptr)
+    {
+        stats.errors++;
+        Report("Error. Job: ", (from == nullptr) ? fromName : toName, " does not exist.\n");
+        return;
+    }
+    if(tickets < 1 || from == to || from->priority - tickets < 1)
+    {
+        stats.errors++;
+        Report("Error. Transfer: ", amount, " tickets can not be moved from ", fromName, " to ", toName, ".\n");
+        return;
+    }
+    Reprioritize(from, from->priority - tickets);
+    Reprioritize(to, to->priority + tickets);
+    stats.priorityChanges += 2;
+    Report("Transfer: ", tickets, " tickets moved from ", from->name, " to ", to->name, ".\n");
+}
+//--
 /*
     OPCODE: finish
     MEANING:    The currently running job has completed and should be removed from the system.
@@ -333,59 +899,67 @@ void Scheduler::FinishJob()
 {
     if(systemRunning)
     {
-        Job cj = *currRunningJob;
-        printf("Job: %s completed.\n", cj.name.c_str());
-        delete currRunningJob;
+        stats.completed++;
+        Report("Job: ", currRunningJob->name, " completed.\n");
+        fairness.Deactivate(currRunningJob->fairness);
+        turnaroundTimes.Record(clock - currRunningJob->arrival);
+        blockedTimes.Record(currRunningJob->blockedTotal);
+        if(keepFinished)
+        {
+            finishedFairness.push_back(FairnessResult{string(currRunningJob->name.View()), currRunningJob->group->name,
+                                                      currRunningJob->fairness, fairness.Ideal(currRunningJob->fairness)});
+        }
+        jobIndex.erase(currRunningJob->name);
+        jobPool.Delete(currRunningJob);
         currRunningJob = nullptr;
         Reschedule();
     }
     else
     {
-        printf("Error. System is idle.\n");
+        stats.errors++;
+        Report("Error. System is idle.\n");
     }
 }
 //--
 /*
-    Find the lowest pass job and schedule it, sending our current running job to the idleJobs
+    Find the lowest pass job and schedule it, sending our current running job back to the idle jobs
+    NOTE: the running job is only returned after the pick, so it never competes against the idle jobs
 */
 void Scheduler::Reschedule()
 {
-    if(idleJobs.size() > 0 || currRunningJob != nullptr)
+    if(idleCount > 0 || currRunningJob != nullptr)
     {
         Job* nextJob = GrabMinPassJob(); // Find the job with the smallest pass
         if(nextJob != nullptr)
         {
             // WE have a new job we need to schedule
-            if(nextJob != currRunningJob)
+            if(currRunningJob != nullptr)
             {
-                // This job not currently running
-                if(currRunningJob != nullptr)
-                {
-                    // WE have something already running
-                    // Thus we need to swap
-                    idleJobs[currRunningJob->name] = currRunningJob; // Add our currently schedule job back
-                    currRunningJob = nextJob;
-                    idleJobs.erase(nextJob->name);
-                    systemRunning = true;
-                }
-                else
-                {
-                    // Nothing is running right now
-                    systemRunning = true;
-                    currRunningJob = nextJob;
-                    idleJobs.erase(currRunningJob->name);
-                }
+                // WE have something already running
+                // Thus we need to swap
+                MakeRunnable(currRunningJob); // Add our currently schedule job back
+                fairness.Descheduled(currRunningJob->fairness, clock);
             }
+            fairness.Scheduled(nextJob->fairness, clock);
+            if(!nextJob->started)
+            {
+                nextJob->started = true;
+                responseTimes.Record(clock - nextJob->arrival);
+            }
+            currRunningJob = nextJob;
+            systemRunning = true;
         }
         if(currRunningJob != nullptr)
         {
             // We have a job running
-            printf("Job: %s scheduled.\n", currRunningJob->name.c_str());
+            stats.schedules++;
+            Report("Job: ", currRunningJob->name, " scheduled.\n");
         }
     }
     else
     {
-        printf("System is idle.\n");
+        stats.idles++;
+        Report("System is idle.\n");
         systemRunning = false;
     }
 }
@@ -400,17 +974,30 @@ void Scheduler::Interrupt()
 {
     if(systemRunning)
     {
-        // If we were running something, increase its pass
+        stats.interrupts++;
+        clock++;
+        // If we were running something, increase its pass (and its group's)
         if(currRunningJob != nullptr)
         {
             currRunningJob->pass += currRunningJob->stride;
+            AdvanceGroup(currRunningJob->group);
+            fairness.Quantum(currRunningJob->fairness);
+            if(currRunningJob->pass >= PASS_RENORMALIZE_AT)
+            {
+                RenormalizeJobs(currRunningJob->group);
+            }
+            if(currRunningJob->group->pass >= PASS_RENORMALIZE_AT)
+            {
+                RenormalizeGroups();
+            }
         }
         Reschedule(); // Run the next job
     }
     else
     {
         // System is IDLE
-        printf("Error. System is idle.\n");
+        stats.errors++;
+        Report("Error. System is idle.\n");
     }
 }
 //--
@@ -424,15 +1011,20 @@ void Scheduler::Block()
     if(systemRunning)
     {
         Job* bljb = currRunningJob; 
-        blockedJobs[bljb->name] = bljb;
-        printf("Job: %s blocked.\n", bljb->name.c_str());
+        bljb->blocked = true;
+        blockedJobs.PushBack(bljb);
+        fairness.Blocked(bljb->fairness);
+        bljb->blockedSince = clock;
+        stats.blocks++;
+        Report("Job: ", bljb->name, " blocked.\n");
         currRunningJob = nullptr;
         Reschedule();
     }
     else
     {
         // System is IDLE
-        printf("Error. System is idle.\n");
+        stats.errors++;
+        Report("Error. System is idle.\n");
     }
 }
 //--
@@ -444,16 +1036,20 @@ void Scheduler::Block()
     It is an error if the named job was not blocked.
     Unblocked jobs return to the runnables. The scheduler is not run unless the system was idle.
 */
-void Scheduler::UnBlock(const string name)
+void Scheduler::UnBlock(string_view name)
 {
-    if(blockedJobs.count(name) > 0)
+    Job* unblockedJob = FindJob(name);
+    if(unblockedJob != nullptr && unblockedJob->blocked)
     {
         // WE HAVE A BLOCKED JOB WITH THAT NAME
-        Job* unblockedJob = blockedJobs[name]; // Grab that blocked job
-        blockedJobs.erase(name); // Remove it from blocked jobs
+        blockedJobs.Remove(unblockedJob); // Remove it from blocked jobs, O(1)
+        unblockedJob->blocked = false;
 
-        idleJobs[unblockedJob->name] = unblockedJob; // Move it into the idle jobs
-        printf("Job: %s has unblocked. Pass set to: %d\n", unblockedJob->name.c_str(), unblockedJob->pass);
+        MakeRunnable(unblockedJob); // Move it into the idle jobs
+        fairness.Activate(unblockedJob->fairness, unblockedJob->priority, clock);
+        unblockedJob->blockedTotal += clock - unblockedJob->blockedSince;
+        stats.unblocks++;
+        Report("Job: ", unblockedJob->name, " has unblocked. Pass set to: ", unblockedJob->pass, '\n');
         // The scheduler is not run unless the system was idle.
         if(!systemRunning)
         {
@@ -464,7 +1060,8 @@ void Scheduler::UnBlock(const string name)
     else
     {
         // Job was not previously blocked!
-        printf("Error. Job: %s not blocked.\n", name.c_str());
+        stats.errors++;
+        Report("Error. Job: ", name, " not blocked.\n");
     }
 }
 //--
@@ -480,28 +1077,22 @@ void Scheduler::UnBlock(const string name)
 */
 void Scheduler::PrintRunnables()
 {
-    list<Job*> allJobs;
-
-    printf("Runnable:\n");
-    if(idleJobs.size() > 0)
+    Report("Runnable:\n");
+    if(idleCount > 0)
     {
-        printf("NAME    STRIDE  PASS  PRI\n");
-        for(map<string, Job*>::iterator it = idleJobs.begin(); it != idleJobs.end(); it++)
-        {
-            // For each job in our idleJobs map
-            allJobs.push_back(it->second); // add it to our listed (used to sort later)
-        }
-        allJobs.sort(CompareJobsByPass); // Sort each idle job by its pass
-
-        // Print out each job in the order it would be scheduled
-        for(list<Job*>::iterator it = allJobs.begin(); it != allJobs.end(); it++)
+        Report("NAME    STRIDE  PASS  PRI\n");
+        // Groups in the order they would be picked, and each group's jobs in the order they would be picked
+        for(Group* group : runnableGroups)
         {
-            printf("%-8s%-8d%-6d%-6d\n", (**it).name.c_str(), (**it).stride, (**it).pass, (**it).priority);
+            for(Job* job : group->runnables)
+            {
+                PrintJob(job);
+            }
         }
     }
     else
     {
-        printf("None\n");
+        Report("None\n");
     }
 }
 //--
@@ -515,15 +1106,15 @@ void Scheduler::PrintRunnables()
 */
 void Scheduler::PrintRunningTask()
 {
-    printf("Running:\n");
+    Report("Running:\n");
     if(currRunningJob != nullptr)
     {
-        printf("NAME    STRIDE  PASS  PRI\n");
-        printf("%-8s%-8d%-6d%-6d\n", currRunningJob->name.c_str(), currRunningJob->stride, currRunningJob->pass, currRunningJob->priority);
+        Report("NAME    STRIDE  PASS  PRI\n");
+        PrintJob(currRunningJob);
     }
     else
     {
-        printf("None\n");
+        Report("None\n");
     }
 }
 //--
@@ -534,20 +1125,37 @@ void Scheduler::PrintRunningTask()
             Blocked:
             NAME    STRIDE  PASS  PRI
             A       500     2000  200
+    Listed by name (the default), or in the order they blocked (see SetBlockedOrder).
 */
 void Scheduler::PrintBlockedTasks()
 {
-    printf("Blocked:\n");
+    Report("Blocked:\n");
     if(blockedJobs.size() > 0)
     {
-        printf("NAME    STRIDE  PASS  PRI\n");
-        for(map<string, Job*>::iterator it = blockedJobs.begin(); it != blockedJobs.end(); it++){
-            printf("%-8s%-8d%-6d%-6d\n", it->second->name.c_str(), it->second->stride, it->second->pass, it->second->priority);
+        Report("NAME    STRIDE  PASS  PRI\n");
+        if(blockedOrder == BLOCKED_BY_TIME)
+        {
+            for(Job* job : blockedJobs)
+            {
+                PrintJob(job);
+            }
+            return;
+        }
+        // Only the listing pays for the sort, blocking & unblocking stay O(1)
+        blockedListing.clear();
+        for(Job* job : blockedJobs)
+        {
+            blockedListing.push_back(job);
+        }
+        sort(blockedListing.begin(), blockedListing.end(), [](const Job* a, const Job* b){ return a->name < b->name; });
+        for(Job* job : blockedListing)
+        {
+            PrintJob(job);
         }
     }
     else
     {
-        printf("None\n");
+        Report("None\n");
     }
 
 }
@@ -1,51 +1,171 @@
 #pragma once
 #include <stdio.h>
 #include <string>
+#include <string_view>
 #include <map>
-#include <fstream>
-#include <list>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <algorithm>
+#include "TraceParser.hpp"
+#include "OutputSink.hpp"
+#include "ObjectPool.hpp"
+#include "InlineName.hpp"
+#include "IntrusiveList.hpp"
+#include "LatencyHistogram.hpp"
+#include "SchedulerStats.hpp"
+#include "Fairness.hpp"
+#include "Snapshot.hpp"
 
 #define STRIDE_PROP 10000
+#define DEFAULT_GROUP "default"
+#define DEFAULT_GROUP_TICKETS 100
+// Once a pass reaches this, every pass at that level is shifted back down towards 0
+#define PASS_RENORMALIZE_AT (uint64_t(1) << 32)
 
-enum OPCODE {INVALID, NEWJOB, FINISH, INTERRUPT, BLOCK, UNBLOCK, RUNNABLE, RUNNING, BLOCKED};
+// The order the blocked command lists the blocked jobs in
+enum BLOCKED_ORDER {BLOCKED_BY_NAME, BLOCKED_BY_TIME};
 
 class Scheduler{
 public:
     Scheduler();
     ~Scheduler();
-    void RunInstructionFile(const std::string filePath);
-    void RunInstructionString(std::string line);
-    void RunCommand(const std::string& com, const std::string& arg1, const int& arg2);
+    void RunInstructionFile(const std::string& filePath);
+    void RunInstructionString(std::string_view line);
+    void RunCommand(const TraceCommand& cmd);
+    void SetVerbose(const bool& on);
+    void SetBlockedOrder(const BLOCKED_ORDER& order);
+    void CaptureOutput(std::string* text);
+    void FlushOutput();
+    const SchedulerStats& Stats() const;
+    void PrintSummary();
+    void PrintLatency();
+    void KeepFinishedJobs(const bool& on);
+    bool ExportFairness(const std::string& filePath);
+    std::string_view RunningJobName() const;
 private:
 
+    struct Group;
+
     struct Job{
-        Job(std::string n, int p) { name = n; priority = p; pass = 0; stride = STRIDE_PROP / priority; }
+        Job(std::string_view n, int p, Group* g, uint64_t now) : name(n), group(g), blocked(false), arrival(now), blockedSince(0), blockedTotal(0), started(false)
+        { priority = p; pass = 0; stride = STRIDE_PROP / priority; }
 
-        std::string name;
-        uint32_t stride;
-        uint32_t pass;
+        InlineName name; // No allocation for short names
+        uint64_t stride;
+        uint64_t pass;
         int priority;
+        Group* group; // The tenant this job's share comes out of
+        bool blocked;
+        ListLinks<Job> blockedLinks; // Place among the blocked jobs, while blocked
+        FairnessRecord fairness;
+        // Simulated clock readings, for the latency histograms
+        uint64_t arrival;
+        uint64_t blockedSince;
+        uint64_t blockedTotal;
+        bool started; // Has run at least once
+    };
+
+    /*
+        Is pass a behind pass b
+        Compared by signed difference, so the order survives passes wrapping around 2^64
+        as long as the passes being compared are within 2^63 of each other
+    */
+    static bool PassBefore(const uint64_t& a, const uint64_t& b)
+    {
+        return int64_t(a - b) < 0;
+    }
+
+    /*
+        Orders jobs (or groups) the way they would be scheduled
+        Lowest pass first, ties go to whichever is first alphabetically by name
+    */
+    struct PassOrder{
+        template <typename T>
+        bool operator()(const T* a, const T* b) const
+        {
+            if(a->pass != b->pass)
+            {
+                return PassBefore(a->pass, b->pass);
+            }
+            return a->name < b->name;
+        }
+    };
+
+    /*
+        A tenant holding tickets, split among its member jobs by their priorities
+        Scheduling picks the lowest pass group first, then the lowest pass job inside it
+    */
+    struct Group{
+        Group(std::string_view n, int t) : name(n) { tickets = t; pass = 0; stride = STRIDE_PROP / tickets; }
+
+        std::string name;
+        uint64_t stride;
+        uint64_t pass;
+        int tickets;
+        std::set<Job*, PassOrder> runnables; // Idle member jobs
     };
 
     // Methods
     Job* GrabMinPassJob();
-    OPCODE ParseCode(const std::string code);
-    void CreateNewJob(const std::string name = "", const int &priority = -1);
+    void MakeRunnable(Job* job);
+    void AdvanceGroup(Group* group);
+    void RenormalizeJobs(Group* group);
+    void RenormalizeGroups();
+    Group* FindGroup(std::string_view name);
+    void CreateGroup(std::string_view name, const int &tickets);
+    void CreateNewJob(std::string_view name, const int &priority = -1, std::string_view groupName = "");
+    Job* FindJob(std::string_view name);
+    void Reprioritize(Job* job, const int &priority);
+    void SetPriority(std::string_view name, const int &priority);
+    void Transfer(std::string_view fromName, std::string_view toName, std::string_view amount);
     void Reschedule();
-    static bool CompareJobsByName(Job* job1, Job* job2);
-    static bool CompareJobsByPass(Job* job1, Job* job2);
+    void Checkpoint(std::string_view filePath);
+    void Restore(std::string_view filePath);
+    void AdvanceClock(std::string_view time);
+    void DeleteEverything();
 
     void FinishJob();
     void Interrupt();
     void Block();
-    void UnBlock(const std::string name);
+    void UnBlock(std::string_view name);
     void PrintRunnables();
     void PrintRunningTask();
     void PrintBlockedTasks();
+    void PrintJob(const Job* job);
+
+    // Per event output, dropped entirely when not verbose
+    template <typename... Args>
+    void Report(const Args&... args)
+    {
+        if(verbose)
+        {
+            out.Write(args...);
+        }
+    }
 
     // Data Members
-    std::map<std::string, Job*> idleJobs;
-    std::map<std::string, Job*> blockedJobs;
+    // std::less<> lets us look jobs & groups up by string_view without building a string
+    std::map<std::string, Group*, std::less<>> groups;
+    std::set<Group*, PassOrder> runnableGroups; // Groups with at least one idle job
+    // Jobs come from the pool, which never moves them, so the index can key on views of the job's own name
+    ObjectPool<Job> jobPool;
+    std::unordered_map<std::string_view, Job*> jobIndex; // Every job in the system by name
+    IntrusiveList<Job, &Job::blockedLinks> blockedJobs; // In the order they blocked
+    BLOCKED_ORDER blockedOrder;
+    std::vector<Job*> blockedListing; // Scratch space for listing the blocked jobs by name
+    size_t idleCount; // Idle jobs across every group
     Job* currRunningJob;
     bool systemRunning;
+    bool verbose;
+    SchedulerStats stats;
+    uint64_t clock; // Simulated time: one tick per interrupt, or set by the time opcode
+    LatencyHistogram responseTimes;     // Arrival to first run
+    LatencyHistogram turnaroundTimes;   // Arrival to finish
+    LatencyHistogram blockedTimes;      // Time spent blocked over a job's whole life, recorded at finish
+    FairnessTracker fairness;
+    bool keepFinished; // Only worth the memory when the numbers will be exported
+    std::vector<FairnessResult> finishedFairness; // Final numbers of jobs that have completed
+    OutputSink out;
 };
\ No newline at end of file
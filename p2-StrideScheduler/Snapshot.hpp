@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+/*
+    Binary checkpoint format of the stride Scheduler (checkpoint,FILE / restore,FILE)
+
+    Layout (fields in the native byte order of the machine that wrote it, every section 8 byte aligned):
+        SnapshotHeader
+        SnapshotGroup[groupCount]
+        SnapshotJob[jobCount]
+        name bytes (not NUL terminated, found by offset & length)
+
+    Records are fixed size plain structs, so a mapped file can be read in place.
+    The header's byteOrder holds SNAPSHOT_BYTE_ORDER as written, so a snapshot from a machine of the other byte order
+    reads back as a different number and is rejected rather than misread.
+    Runnable jobs are stored in the order they would be scheduled,
+    so they can be put back into the run queues without re-sorting.
+
+    Any change to the layout must bump SNAPSHOT_VERSION.
+*/
+
+const char SNAPSHOT_MAGIC[8] = {'S', 'T', 'R', 'D', 'S', 'N', 'A', 'P'};
+const uint32_t SNAPSHOT_VERSION = 2;
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+enum SNAPSHOT_JOB_STATE : uint32_t {SNAP_RUNNABLE, SNAP_RUNNING, SNAP_BLOCKED};
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t byteOrder;     // SNAPSHOT_BYTE_ORDER
+    uint32_t version;
+    uint32_t systemRunning;
+    uint32_t reserved;      // Written as 0, keeps the counts 8 byte aligned
+    uint64_t groupCount;
+    uint64_t jobCount;
+    uint64_t nameBytes;
+};
+
+struct SnapshotGroup
+{
+    uint64_t stride;
+    uint64_t pass;
+    int32_t tickets;
+    uint32_t nameLength;
+    uint64_t nameOffset;
+};
+
+struct SnapshotJob
+{
+    uint64_t stride;
+    uint64_t pass;
+    int32_t priority;
+    uint32_t group;         // Index into the groups
+    uint32_t state;         // SNAPSHOT_JOB_STATE
+    uint32_t nameLength;
+    uint64_t nameOffset;
+};
+
+static_assert(sizeof(SnapshotHeader) % 8 == 0, "Snapshot sections must stay 8 byte aligned");
+static_assert(sizeof(SnapshotGroup) % 8 == 0, "Snapshot sections must stay 8 byte aligned");
+static_assert(sizeof(SnapshotJob) % 8 == 0, "Snapshot sections must stay 8 byte aligned");
@@ -0,0 +1,185 @@
+#include "WorkloadGenerator.hpp"
+#include <math.h>
+#include <stdlib.h>
+#include <charconv>
+#include <algorithm>
+
+using namespace std;
+
+WorkloadGenerator::WorkloadGenerator(const WorkloadOptions& options) : opts(options), rng(options.seed)
+{
+    step = 0;
+    arrived = 0;
+    finished = 0;
+    lines = 0;
+    if(opts.concurrency == 0)
+    {
+        opts.concurrency = opts.jobs;
+    }
+    if(opts.meanLength < 1)
+    {
+        opts.meanLength = 1;
+    }
+    shadow.SetVerbose(false);
+    if(opts.priDist == ZIPF_PRI)
+    {
+        BuildZipfTable();
+    }
+}
+//--
+/*
+    Split "uniform:LO:HI", "bimodal:LO:HI:P" or "zipf:N:S" into the options
+*/
+bool ParsePriorityDist(const string& spec, WorkloadOptions& opts)
+{
+    vector<string> parts = SplitSpec(spec);
+    if(parts[0] == "uniform" && parts.size() == 3)
+    {
+        opts.priDist = UNIFORM_PRI;
+        opts.priLow = atoi(parts[1].c_str());
+        opts.priHigh = atoi(parts[2].c_str());
+    }
+    else if(parts[0] == "bimodal" && parts.size() == 4)
+    {
+        opts.priDist = BIMODAL_PRI;
+        opts.priLow = atoi(parts[1].c_str());
+        opts.priHigh = atoi(parts[2].c_str());
+        opts.priParam = atof(parts[3].c_str());
+    }
+    else if(parts[0] == "zipf" && parts.size() == 3)
+    {
+        opts.priDist = ZIPF_PRI;
+        opts.priLow = 1;
+        opts.priHigh = atoi(parts[1].c_str());
+        opts.priParam = atof(parts[2].c_str());
+    }
+    else
+    {
+        return false;
+    }
+    // A priority above STRIDE_PROP would give a stride of 0
+    return opts.priLow >= 1 && opts.priHigh >= opts.priLow && opts.priHigh <= STRIDE_PROP;
+}
+//--
+bool WorkloadGenerator::Next(string_view& out)
+{
+    if(opts.maxLines > 0 && lines >= opts.maxLines)
+    {
+        return false;
+    }
+
+    if(pending.size() > 0 && pending.top().due <= step)
+    {
+        // A blocked job's I/O is done
+        Emit("unblock", pending.top().id, -1, true);
+        pending.pop();
+    }
+    else if(arrived < opts.jobs && arrived - finished < opts.concurrency)
+    {
+        Emit("newjob", arrived, NextPriority(), true);
+        arrived++;
+    }
+    else if(shadow.RunningJobName().size() > 0)
+    {
+        // The running job uses up its quantum one way or another
+        step++;
+        if(rng.Uniform() * opts.meanLength < 1)
+        {
+            Emit("finish");
+            finished++;
+        }
+        else if(rng.Uniform() < opts.blockRate)
+        {
+            string_view name = shadow.RunningJobName();
+            uint64_t id = 0;
+            from_chars(name.data() + 1, name.data() + name.size(), id);
+            pending.push(PendingUnblock{step + rng.Geometric(opts.meanBlockLength), id});
+            Emit("block");
+        }
+        else
+        {
+            Emit("interrupt");
+        }
+    }
+    else if(pending.size() > 0)
+    {
+        // Idle until the next blocked job comes back
+        step = pending.top().due;
+        Emit("unblock", pending.top().id, -1, true);
+        pending.pop();
+    }
+    else
+    {
+        // Every job has arrived and finished
+        return false;
+    }
+    out = line;
+    return true;
+}
+//--
+/*
+    Build the line, and run it through the shadow scheduler so we know what happens next
+*/
+void WorkloadGenerator::Emit(string_view opcode, const uint64_t& id, const int& priority, const bool& hasName)
+{
+    char digits[24];
+    line.assign(opcode);
+    if(hasName)
+    {
+        line += ",J";
+        line.append(digits, to_chars(digits, digits + sizeof(digits), id).ptr - digits);
+    }
+    if(priority > 0)
+    {
+        line += ',';
+        line.append(digits, to_chars(digits, digits + sizeof(digits), priority).ptr - digits);
+    }
+    shadow.RunInstructionString(line);
+    lines++;
+}
+//--
+int WorkloadGenerator::NextPriority()
+{
+    switch(opts.priDist)
+    {
+        case BIMODAL_PRI:
+        {
+            return (rng.Uniform() < opts.priParam) ? opts.priLow : opts.priHigh;
+        }
+        case ZIPF_PRI:
+        {
+            // Rank 1 is the most common, and gets the highest priority
+            double u = rng.Uniform();
+            size_t rank = lower_bound(zipfCdf.begin(), zipfCdf.end(), u) - zipfCdf.begin();
+            if(rank >= zipfCdf.size())
+            {
+                rank = zipfCdf.size() - 1;
+            }
+            return opts.priHigh - int(rank);
+        }
+        case UNIFORM_PRI:
+        default:
+        {
+            return opts.priLow + int(rng.Next() % uint64_t(opts.priHigh - opts.priLow + 1));
+        }
+    }
+}
+//--
+/*
+    Cumulative probabilities of each zipf rank, searched by NextPriority
+*/
+void WorkloadGenerator::BuildZipfTable()
+{
+    zipfCdf.resize(opts.priHigh);
+    double sum = 0;
+    for(int rank = 1; rank <= opts.priHigh; rank++)
+    {
+        sum += 1.0 / pow(double(rank), opts.priParam);
+        zipfCdf[rank - 1] = sum;
+    }
+    for(double& p : zipfCdf)
+    {
+        p /= sum;
+    }
+}
+//--
@@ -0,0 +1,78 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <queue>
+#include "Scheduler.hpp"
+#include "Random.hpp"
+
+/*
+    Synthetic trace generator for the stride simulator
+
+    Emits lines in the usual trace format (newjob,NAME,PRI / interrupt / block / unblock,NAME / finish).
+    The generator shadows its own output with a quiet stride Scheduler,
+    so it always knows which job is running and only ever unblocks jobs that really are blocked.
+    NOTE: the shadow is the stride policy, other policies may block different jobs on the same trace.
+*/
+
+enum PRIORITY_DIST {UNIFORM_PRI, BIMODAL_PRI, ZIPF_PRI};
+
+struct WorkloadOptions
+{
+    uint64_t jobs = 1000;           // Total number of jobs that arrive
+    uint64_t concurrency = 0;       // Most jobs alive at once, 0 means every job arrives up front
+    uint64_t maxLines = 0;          // Stop after this many lines, 0 means run until every job finishes
+    double meanLength = 4;          // Mean quanta a job runs before it finishes
+    double blockRate = 0.1;         // Chance a quantum ends with the job blocking
+    double meanBlockLength = 8;     // Mean quanta a blocked job stays blocked
+    PRIORITY_DIST priDist = UNIFORM_PRI;
+    int priLow = 1;                 // uniform: lowest priority       bimodal: the low priority   zipf: unused
+    int priHigh = 1000;             // uniform: highest priority      bimodal: the high priority  zipf: number of ranks
+    double priParam = 0.5;          // uniform: unused                bimodal: chance of low      zipf: exponent
+    uint64_t seed = 1;
+};
+
+/*
+    Parse a priority distribution of the form
+        uniform:LO:HI   bimodal:LO:HI:P   zipf:N:S
+    Returns false if the spec is malformed
+*/
+bool ParsePriorityDist(const std::string& spec, WorkloadOptions& opts);
+
+class WorkloadGenerator
+{
+public:
+    WorkloadGenerator(const WorkloadOptions& options);
+
+    /*
+        Produce the next line of the trace (without its newline)
+        The view stays valid until the next call
+    Return:
+        bool --> false once the trace is complete
+    */
+    bool Next(std::string_view& line);
+
+private:
+    struct PendingUnblock
+    {
+        uint64_t due;
+        uint64_t id;
+        bool operator>(const PendingUnblock& other) const { return due > other.due; }
+    };
+
+    int NextPriority();
+    void BuildZipfTable();
+    void Emit(std::string_view opcode, const uint64_t& id = 0, const int& priority = -1, const bool& hasName = false);
+
+    WorkloadOptions opts;
+    Scheduler shadow;
+    std::priority_queue<PendingUnblock, std::vector<PendingUnblock>, std::greater<PendingUnblock>> pending;
+    std::vector<double> zipfCdf;
+    std::string line;
+    SplitMix64 rng;
+    uint64_t step;          // Quanta elapsed
+    uint64_t arrived;
+    uint64_t finished;
+    uint64_t lines;
+};
@@ -1,14 +1,206 @@
 #include <stdio.h>
+#include <string.h>
+#include <getopt.h>
 #include "Scheduler.hpp"
+#include "LotteryScheduler.hpp"
+#include "FairQueueScheduler.hpp"
+#include "TraceStreams.hpp"
 
 using namespace std;
 
-int main(int argc, char * argv[]) {
-	Scheduler sch;
-	if(argc > 1){
+enum POLICY {STRIDE, LOTTERY, WFQ, WF2Q};
+
+struct Options
+{
+	POLICY policy = STRIDE;
+	uint64_t seed = 1;
+	bool summaryOnly = false;
+	bool latency = false;	// Print response / turnaround / blocked time percentiles at exit
+	bool merge = false;		// Every file is a timestamped stream, merged by timestamp
+	BLOCKED_ORDER blockedOrder = BLOCKED_BY_NAME;	// How the blocked listing is sorted: by name, or by when each job blocked
+	string fairnessPath;	// Empty when no fairness export was asked for
+};
+
+void HandleOptions(int argc, char* argv[], Options& opts);
+void PrintUsage();
+
+/*
+	Every policy is driven the same way, whichever one was picked
+*/
+template <typename Policy>
+void RunTrace(Policy& sch, const Options& opts, int argc, char* argv[])
+{
+	sch.SetVerbose(!opts.summaryOnly);
+	if(opts.merge){
+		// One producer thread per stream, the scheduler consumes on this thread
+		TraceStreams streams;
+		if(!streams.Open(vector<string>(argv + optind, argv + argc))){
+			exit(1);
+		}
+		streams.Run([&sch](const TraceCommand& cmd){ sch.RunCommand(cmd); });
+	}
+	else if(optind < argc){
 		// Filename included
-		string filePath = string(argv[1]);
+		string filePath = string(argv[optind]);
 		sch.RunInstructionFile(filePath);
 	}
+	if(opts.summaryOnly){
+		sch.PrintSummary();
+	}
+}
+
+int main(int argc, char * argv[]) {
+	Options opts;
+	HandleOptions(argc, argv, opts);
+
+	if((opts.policy == WFQ || opts.policy == WF2Q) && (opts.fairnessPath.size() > 0 || opts.latency)){
+		fprintf(stderr, "ERROR: Fairness & latency numbers are only available for the stride & lottery policies\n");
+		exit(1);
+	}
+	if(opts.policy == LOTTERY){
+		LotteryScheduler sch(opts.seed);
+		sch.KeepFinishedJobs(opts.fairnessPath.size() > 0);
+		RunTrace(sch, opts, argc, argv);
+		if(opts.fairnessPath.size() > 0){
+			sch.ExportFairness(opts.fairnessPath);
+		}
+		if(opts.latency){
+			sch.PrintLatency();
+		}
+	}
+	else if(opts.policy == WFQ || opts.policy == WF2Q){
+		FairQueueScheduler sch(opts.policy == WF2Q);
+		RunTrace(sch, opts, argc, argv);
+	}
+	else{
+		Scheduler sch;
+		sch.KeepFinishedJobs(opts.fairnessPath.size() > 0);
+		sch.SetBlockedOrder(opts.blockedOrder);
+		RunTrace(sch, opts, argc, argv);
+		if(opts.fairnessPath.size() > 0){
+			sch.ExportFairness(opts.fairnessPath);
+		}
+		if(opts.latency){
+			sch.PrintLatency();
+		}
+	}
 	return 0;
 }
+//--
+/*
+	Read in the command line options
+	-p / --policy NAME				stride (default), lottery, wfq or wf2q
+	-r / --seed N					seed for the lottery's random draws
+	-f / --fairness FILE			export per job fairness & latency numbers at exit (.json for JSON, else CSV)
+	-q / --quiet, -s / --summary	suppress the per event lines, print only the summary at the end
+	-l / --latency					print response / turnaround / blocked time percentiles at the end
+	-b / --blocked-order ORDER		list blocked jobs by name (default) or by time (the order they blocked)
+	-m / --merge					every file is a timestamped stream, read in parallel & merged by timestamp
+									(implied when more than one file is given)
+*/
+void HandleOptions(int argc, char* argv[], Options& opts)
+{
+	static const struct option longOptions[] = {
+		{"policy",	required_argument,	nullptr, 'p'},
+		{"seed",	required_argument,	nullptr, 'r'},
+		{"fairness",	required_argument,	nullptr, 'f'},
+		{"quiet",	no_argument,		nullptr, 'q'},
+		{"summary",	no_argument,		nullptr, 's'},
+		{"merge",	no_argument,		nullptr, 'm'},
+		{"latency",	no_argument,		nullptr, 'l'},
+		{"blocked-order",	required_argument,	nullptr, 'b'},
+		{nullptr,	0,					nullptr, 0}
+	};
+
+	int c;
+	while ((c = getopt_long(argc, argv, "p:r:f:qsmlb:", longOptions, nullptr)) != -1)
+	{
+		switch(c)
+		{
+			case 'p':
+			{
+				if(strcmp(optarg, "stride") == 0){
+					opts.policy = STRIDE;
+				}
+				else if(strcmp(optarg, "lottery") == 0){
+					opts.policy = LOTTERY;
+				}
+				else if(strcmp(optarg, "wfq") == 0){
+					opts.policy = WFQ;
+				}
+				else if(strcmp(optarg, "wf2q") == 0){
+					opts.policy = WF2Q;
+				}
+				else{
+					fprintf(stderr, "Unknown policy: %s\n", optarg);
+					PrintUsage();
+					exit(1);
+				}
+				break;
+			}
+			case 'r':
+			{
+				opts.seed = strtoull(optarg, nullptr, 10);
+				break;
+			}
+			case 'f':
+			{
+				opts.fairnessPath = string(optarg);
+				break;
+			}
+			case 'q':
+			case 's':
+			{
+				opts.summaryOnly = true;
+				break;
+			}
+			case 'm':
+			{
+				opts.merge = true;
+				break;
+			}
+			case 'l':
+			{
+				opts.latency = true;
+				break;
+			}
+			case 'b':
+			{
+				if(strcmp(optarg, "name") == 0){
+					opts.blockedOrder = BLOCKED_BY_NAME;
+				}
+				else if(strcmp(optarg, "time") == 0){
+					opts.blockedOrder = BLOCKED_BY_TIME;
+				}
+				else{
+					fprintf(stderr, "Unknown blocked order: %s\n", optarg);
+					PrintUsage();
+					exit(1);
+				}
+				break;
+			}
+			default:
+			{
+				PrintUsage();
+				exit(1);
+			}
+		}
+	}
+	if(argc - optind > 1){
+		opts.merge = true;
+	}
+}
+//--
+void PrintUsage()
+{
+	fprintf(stderr, "Usage: a.out [options] instruction_file [more_instruction_files...]\n");
+	fprintf(stderr, "-p, --policy NAME	(OPT)	stride (default), lottery, wfq or wf2q (WF2Q+)\n");
+	fprintf(stderr, "-r, --seed N		(OPT)	seed for the lottery's random draws (default 1)\n");
+	fprintf(stderr, "-f, --fairness FILE	(OPT)	export per job fairness numbers at exit (.json for JSON, else CSV)\n");
+	fprintf(stderr, "-q, --quiet		(OPT)	print only summary statistics, no per event lines\n");
+	fprintf(stderr, "-s, --summary		(OPT)	same as --quiet\n");
+	fprintf(stderr, "-l, --latency		(OPT)	print response / turnaround / blocked time p50, p99 & p999 at exit\n");
+	fprintf(stderr, "-b, --blocked-order ORDER (OPT) list blocked jobs by name (default) or time (the order they blocked, stride only)\n");
+	fprintf(stderr, "-m, --merge		(OPT)	files are timestamped streams (TIMESTAMP,opcode,...) merged by timestamp\n");
+	fprintf(stderr, "			 	implied when more than one file is given\n");
+}
@@ -0,0 +1,215 @@
+/*
+	Scaling benchmark for the stride Scheduler
+
+	For each job count, a synthetic trace is generated into a temporary file:
+	every job arrives up front, followed by a fixed number of scheduling events.
+	The trace is then run twice on fresh, quiet schedulers:
+		once end to end, mapped & parsed by TraceReader just as a.out reads a trace,
+		once for a per opcode cost, with the commands parsed ahead a chunk at a time
+		and each run of the same opcode timed as one batch, so the clock is read once per batch, not twice per instruction.
+	The cost of reading the clock is measured up front and taken off every batch.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <chrono>
+#include <vector>
+#include <string>
+#include "WorkloadGenerator.hpp"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+void HandleOptions(int argc, char* argv[], vector<uint64_t>& sizes, uint64_t& events, WorkloadOptions& opts);
+void PrintUsage();
+bool WriteTrace(const WorkloadOptions& opts, string& filePath);
+double ClockNanos();
+void RunBenchmark(const uint64_t& jobs, const string& filePath, const double& clockNanos);
+
+
+int main(int argc, char * argv[]) {
+	vector<uint64_t> sizes;
+	uint64_t events = 1000000;
+	WorkloadOptions opts;
+	opts.meanLength = 1000; // Jobs mostly outlive the run, so the run queue stays at full size
+	HandleOptions(argc, argv, sizes, events, opts);
+	if(sizes.size() == 0){
+		sizes = {1000, 100000, 10000000};
+	}
+
+	double clockNanos = ClockNanos();
+	for(uint64_t jobs : sizes){
+		opts.jobs = jobs;
+		opts.concurrency = jobs;
+		opts.maxLines = jobs + events;
+		string filePath;
+		if(!WriteTrace(opts, filePath)){
+			exit(1);
+		}
+		RunBenchmark(jobs, filePath, clockNanos);
+		unlink(filePath.c_str());
+	}
+	return 0;
+}
+//--
+/*
+	Write the whole trace to a new temporary file (in $TMPDIR, or /tmp), and hand back its path
+*/
+bool WriteTrace(const WorkloadOptions& opts, string& filePath)
+{
+	const char* dir = getenv("TMPDIR");
+	filePath = string((dir != nullptr && dir[0] != '\0') ? dir : "/tmp") + "/stride_bench_XXXXXX";
+	int fd = mkstemp(&filePath[0]);
+	FILE* fout = (fd >= 0) ? fdopen(fd, "w") : nullptr;
+	if(fout == nullptr){
+		fprintf(stderr, "Trace file could not be created: %s\n", filePath.c_str());
+		return false;
+	}
+	WorkloadGenerator gen(opts);
+	string_view line;
+	while(gen.Next(line)){
+		fwrite(line.data(), 1, line.size(), fout);
+		fputc('\n', fout);
+	}
+	if(fclose(fout) != 0){
+		fprintf(stderr, "Trace file could not be written: %s\n", filePath.c_str());
+		unlink(filePath.c_str());
+		return false;
+	}
+	return true;
+}
+//--
+/*
+	Mean cost of one steady_clock reading, taken off each timed batch
+*/
+double ClockNanos()
+{
+	const int READS = 1000000;
+	Clock::time_point start = Clock::now();
+	Clock::time_point last = start;
+	for(int i = 0; i < READS; i++){
+		last = Clock::now();
+	}
+	return chrono::duration<double, nano>(last - start).count() / READS;
+}
+//--
+void RunBenchmark(const uint64_t& jobs, const string& filePath, const double& clockNanos)
+{
+	const size_t CHUNK = 4096;
+	TraceCommand cmd;
+	uint64_t instructions = 0;
+
+	// End to end: map, parse and run everything
+	double totalSeconds;
+	{
+		Scheduler sch;
+		sch.SetVerbose(false);
+		Clock::time_point start = Clock::now();
+		TraceReader trace;
+		if(!trace.Open(filePath.c_str())){
+			fprintf(stderr, "Trace file failed to open: %s\n", filePath.c_str());
+			exit(1);
+		}
+		while(trace.Next(cmd)){
+			sch.RunCommand(cmd);
+			instructions++;
+		}
+		totalSeconds = chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	// Per opcode: parse a chunk untimed, then time each run of the same opcode in it as one batch
+	vector<double> opNanos(OPCODE_COUNT, 0);
+	vector<uint64_t> opCounts(OPCODE_COUNT, 0);
+	vector<uint64_t> opBatches(OPCODE_COUNT, 0);
+	{
+		Scheduler sch;
+		sch.SetVerbose(false);
+		TraceReader trace;
+		trace.Open(filePath.c_str());
+		vector<TraceCommand> chunk;
+		chunk.reserve(CHUNK);
+		bool more = true;
+		while(more){
+			chunk.clear();
+			while(chunk.size() < CHUNK && (more = trace.Next(cmd))){
+				chunk.push_back(cmd);
+			}
+			size_t next = 0;
+			Clock::time_point start = Clock::now();
+			while(next < chunk.size()){
+				OPCODE op = chunk[next].opcode;
+				size_t first = next;
+				for(; next < chunk.size() && chunk[next].opcode == op; next++){
+					sch.RunCommand(chunk[next]);
+				}
+				Clock::time_point stop = Clock::now();
+				opNanos[op] += chrono::duration<double, nano>(stop - start).count() - clockNanos;
+				opCounts[op] += next - first;
+				opBatches[op]++;
+				start = stop;
+			}
+		}
+	}
+
+	printf("jobs: %llu  instructions: %llu  total: %.3f s  (%.1f ns/instruction)\n",
+		(unsigned long long)jobs, (unsigned long long)instructions, totalSeconds,
+		totalSeconds * 1e9 / double(instructions > 0 ? instructions : 1));
+	printf("    %-10s %12s %12s %12s\n", "opcode", "count", "batches", "ns/op");
+	for(size_t op = 0; op < OPCODE_COUNT; op++){
+		if(opCounts[op] > 0){
+			double nanos = (opNanos[op] > 0) ? opNanos[op] / double(opCounts[op]) : 0;
+			printf("    %-10s %12llu %12llu %12.1f\n", OpcodeName(OPCODE(op)), (unsigned long long)opCounts[op],
+				(unsigned long long)opBatches[op], nanos);
+		}
+	}
+	fflush(stdout);
+}
+//--
+void HandleOptions(int argc, char* argv[], vector<uint64_t>& sizes, uint64_t& events, WorkloadOptions& opts)
+{
+	static const struct option longOptions[] = {
+		{"jobs",		required_argument,	nullptr, 'j'},
+		{"events",		required_argument,	nullptr, 'e'},
+		{"block-rate",	required_argument,	nullptr, 'b'},
+		{"pri",			required_argument,	nullptr, 'p'},
+		{"seed",		required_argument,	nullptr, 'r'},
+		{nullptr,		0,					nullptr, 0}
+	};
+
+	int c;
+	while ((c = getopt_long(argc, argv, "j:e:b:p:r:", longOptions, nullptr)) != -1)
+	{
+		switch(c)
+		{
+			case 'j': sizes.push_back(strtoull(optarg, nullptr, 10)); break;
+			case 'e': events = strtoull(optarg, nullptr, 10); break;
+			case 'b': opts.blockRate = atof(optarg); break;
+			case 'r': opts.seed = strtoull(optarg, nullptr, 10); break;
+			case 'p':
+			{
+				if(!ParsePriorityDist(optarg, opts)){
+					fprintf(stderr, "Invalid priority distribution: %s\n", optarg);
+					exit(1);
+				}
+				break;
+			}
+			default:
+			{
+				PrintUsage();
+				exit(1);
+			}
+		}
+	}
+}
+//--
+void PrintUsage()
+{
+	fprintf(stderr, "Usage: bench [options]\n");
+	fprintf(stderr, "-j, --jobs N			job count to run, repeatable (default 1000, 100000 and 10000000)\n");
+	fprintf(stderr, "-e, --events N			scheduling events after the arrivals (default 1000000)\n");
+	fprintf(stderr, "-b, --block-rate P		chance a quantum ends in a block (default 0.1)\n");
+	fprintf(stderr, "-p, --pri DIST			uniform:LO:HI, bimodal:LO:HI:P or zipf:N:S\n");
+	fprintf(stderr, "-r, --seed N			random seed (default 1)\n");
+}
@@ -0,0 +1,85 @@
+/*
+	Synthetic trace generator for the stride scheduler
+	Writes a trace (newjob,NAME,PRI / interrupt / block / unblock,NAME / finish) to stdout
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include "WorkloadGenerator.hpp"
+#include "OutputSink.hpp"
+
+using namespace std;
+
+void HandleOptions(int argc, char* argv[], WorkloadOptions& opts);
+void PrintUsage();
+
+int main(int argc, char * argv[]) {
+	WorkloadOptions opts;
+	HandleOptions(argc, argv, opts);
+
+	WorkloadGenerator gen(opts);
+	OutputSink out;
+	string_view line;
+	while(gen.Next(line)){
+		out.Write(line, '\n');
+	}
+	return 0;
+}
+//--
+void HandleOptions(int argc, char* argv[], WorkloadOptions& opts)
+{
+	static const struct option longOptions[] = {
+		{"jobs",			required_argument,	nullptr, 'j'},
+		{"concurrency",		required_argument,	nullptr, 'c'},
+		{"lines",			required_argument,	nullptr, 'n'},
+		{"length",			required_argument,	nullptr, 'l'},
+		{"block-rate",		required_argument,	nullptr, 'b'},
+		{"block-length",	required_argument,	nullptr, 'B'},
+		{"pri",				required_argument,	nullptr, 'p'},
+		{"seed",			required_argument,	nullptr, 'r'},
+		{nullptr,			0,					nullptr, 0}
+	};
+
+	int c;
+	while ((c = getopt_long(argc, argv, "j:c:n:l:b:B:p:r:", longOptions, nullptr)) != -1)
+	{
+		switch(c)
+		{
+			case 'j': opts.jobs = strtoull(optarg, nullptr, 10); break;
+			case 'c': opts.concurrency = strtoull(optarg, nullptr, 10); break;
+			case 'n': opts.maxLines = strtoull(optarg, nullptr, 10); break;
+			case 'l': opts.meanLength = atof(optarg); break;
+			case 'b': opts.blockRate = atof(optarg); break;
+			case 'B': opts.meanBlockLength = atof(optarg); break;
+			case 'r': opts.seed = strtoull(optarg, nullptr, 10); break;
+			case 'p':
+			{
+				if(!ParsePriorityDist(optarg, opts)){
+					fprintf(stderr, "Invalid priority distribution: %s\n", optarg);
+					PrintUsage();
+					exit(1);
+				}
+				break;
+			}
+			default:
+			{
+				PrintUsage();
+				exit(1);
+			}
+		}
+	}
+}
+//--
+void PrintUsage()
+{
+	fprintf(stderr, "Usage: gen [options] > trace.txt\n");
+	fprintf(stderr, "-j, --jobs N			total jobs that arrive (default 1000)\n");
+	fprintf(stderr, "-c, --concurrency N		most jobs alive at once (default: all arrive up front)\n");
+	fprintf(stderr, "-n, --lines N			stop after N lines (default: when every job finishes)\n");
+	fprintf(stderr, "-l, --length Q			mean quanta a job runs before finishing (default 4)\n");
+	fprintf(stderr, "-b, --block-rate P		chance a quantum ends in a block (default 0.1)\n");
+	fprintf(stderr, "-B, --block-length Q	mean quanta a job stays blocked (default 8)\n");
+	fprintf(stderr, "-p, --pri DIST			uniform:LO:HI (default uniform:1:1000), bimodal:LO:HI:P or zipf:N:S\n");
+	fprintf(stderr, "-r, --seed N			random seed (default 1)\n");
+}
@@ -0,0 +1,366 @@
+/*
+	Parallel regression runner for the stride Scheduler (make check)
+
+	Every tests/NAME.input.txt is run through its own in-process scheduler,
+	its output captured in memory and compared with tests/NAME.expected_output.txt,
+	the same check expected_output_test.bash makes one test at a time.
+	A test with a NAME.args.txt is run with the options in it: -p (policy), -r (seed), -b (blocked order) & -q / -s.
+	One that needs any other option is left to expected_output_test.bash and only listed as skipped.
+	Synthetic traces from the WorkloadGenerator are run as well:
+	they have no expected output, but a generated trace is valid by construction,
+	so any error the Scheduler reports on one is a failure.
+
+	Cases are handed out to a pool of worker threads.
+	Each case owns its Scheduler (and so its output), nothing else is shared.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Scheduler.hpp"
+#include "LotteryScheduler.hpp"
+#include "FairQueueScheduler.hpp"
+#include "WorkloadGenerator.hpp"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+struct TestCase
+{
+	string name;
+	string inputPath;		// Empty for a generated trace
+	string expectedPath;
+	WorkloadOptions workload;
+	string policy = "stride";	// The rest come from the test's .args.txt, if it has one
+	uint64_t seed = 1;
+	BLOCKED_ORDER blockedOrder = BLOCKED_BY_NAME;
+	bool summaryOnly = false;
+	bool latency = false;
+	bool passed = false;
+	string detail;			// Why it failed
+};
+
+void HandleOptions(int argc, char* argv[], string& testDir, unsigned& threads, uint64_t& generated, uint64_t& jobs);
+void PrintUsage();
+bool ReadWholeFile(const string& filePath, string& text);
+bool ReadTestArgs(const string& filePath, TestCase& test, string& problem);
+void RunFileCase(TestCase& test);
+void RunGeneratedCase(TestCase& test);
+string FirstDifference(const string& actual, const string& expected);
+
+
+int main(int argc, char * argv[]) {
+	string testDir = "tests";
+	unsigned threads = max(1u, thread::hardware_concurrency());
+	uint64_t generated = 8;
+	uint64_t jobs = 20000;
+	HandleOptions(argc, argv, testDir, threads, generated, jobs);
+
+	vector<TestCase> cases;
+	vector<string> skipped;
+	error_code ec;
+	for(const filesystem::directory_entry& entry : filesystem::directory_iterator(testDir, ec)){
+		string file = entry.path().filename().string();
+		const string suffix = ".input.txt";
+		if(file.size() > suffix.size() && file.compare(file.size() - suffix.size(), suffix.size(), suffix) == 0){
+			TestCase test;
+			test.name = file.substr(0, file.size() - suffix.size());
+			string argsPath = testDir + "/" + test.name + ".args.txt";
+			string problem;
+			if(filesystem::exists(argsPath) && !ReadTestArgs(argsPath, test, problem)){
+				skipped.push_back(test.name + " (" + problem + ", run it with expected_output_test.bash)");
+				continue;
+			}
+			test.inputPath = entry.path().string();
+			test.expectedPath = testDir + "/" + test.name + ".expected_output.txt";
+			cases.push_back(test);
+		}
+	}
+	if(ec){
+		fprintf(stderr, "ERROR: Test directory could not be read (%s)\n", testDir.c_str());
+		return 1;
+	}
+	sort(cases.begin(), cases.end(), [](const TestCase& a, const TestCase& b){ return a.name < b.name; });
+
+	// Each generated trace gets its own seed & a different mix of blocking
+	for(uint64_t i = 0; i < generated; i++){
+		TestCase test;
+		test.name = "generated" + to_string(i + 1);
+		test.workload.seed = i + 1;
+		test.workload.jobs = jobs;
+		test.workload.concurrency = 1 + jobs / (1 + i * 10);
+		test.workload.blockRate = 0.05 * double(i % 4);
+		test.workload.priDist = (i % 2 == 0) ? UNIFORM_PRI : ZIPF_PRI;
+		test.workload.priLow = 1;
+		test.workload.priHigh = (i % 2 == 0) ? 1000 : 100;
+		test.workload.priParam = 1.1;
+		cases.push_back(test);
+	}
+
+	Clock::time_point start = Clock::now();
+	atomic<size_t> next(0);
+	vector<thread> workers;
+	for(unsigned t = 0; t < threads; t++){
+		workers.emplace_back([&cases, &next](){
+			for(size_t i = next++; i < cases.size(); i = next++){
+				if(cases[i].inputPath.size() > 0){
+					RunFileCase(cases[i]);
+				}
+				else{
+					RunGeneratedCase(cases[i]);
+				}
+			}
+		});
+	}
+	for(thread& worker : workers){
+		worker.join();
+	}
+	double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+	size_t failed = 0;
+	for(const TestCase& test : cases){
+		printf("%s %s%s\n", test.passed ? "PASSED" : "FAILED", test.name.c_str(), test.detail.c_str());
+		failed += test.passed ? 0 : 1;
+	}
+	sort(skipped.begin(), skipped.end());
+	for(const string& name : skipped){
+		printf("SKIPPED %s\n", name.c_str());
+	}
+	printf("%zu passed, %zu failed, %zu skipped in %.3f s (%u threads)\n", cases.size() - failed, failed, skipped.size(), seconds, threads);
+	return (failed == 0) ? 0 : 1;
+}
+//--
+/*
+	Every policy is driven the same way, as main's RunTrace drives it
+*/
+template <typename Policy>
+void RunTraceText(Policy& sch, const string& trace, const TestCase& test, string& actual)
+{
+	sch.CaptureOutput(&actual);
+	sch.SetVerbose(!test.summaryOnly);
+	size_t pos = 0;
+	while(pos < trace.size()){
+		size_t nl = trace.find('\n', pos);
+		if(nl == string::npos){
+			nl = trace.size();
+		}
+		sch.RunInstructionString(string_view(trace).substr(pos, nl - pos));
+		pos = nl + 1;
+	}
+	if(test.summaryOnly){
+		sch.PrintSummary();
+	}
+	sch.FlushOutput();
+}
+//--
+/*
+	Run one tests/NAME.input.txt through the policy its options pick and compare with its expected output
+*/
+void RunFileCase(TestCase& test)
+{
+	string trace;
+	string expected;
+	if(!ReadWholeFile(test.inputPath, trace) || !ReadWholeFile(test.expectedPath, expected)){
+		test.detail = " (input or expected output could not be read)";
+		return;
+	}
+	string actual;
+	if(test.policy == "lottery"){
+		LotteryScheduler sch(test.seed);
+		RunTraceText(sch, trace, test, actual);
+		if(test.latency){
+			sch.PrintLatency();
+		}
+	}
+	else if(test.policy == "wfq" || test.policy == "wf2q"){
+		FairQueueScheduler sch(test.policy == "wf2q");
+		RunTraceText(sch, trace, test, actual);
+	}
+	else{
+		Scheduler sch;
+		sch.SetBlockedOrder(test.blockedOrder);
+		RunTraceText(sch, trace, test, actual);
+		if(test.latency){
+			sch.PrintLatency();
+		}
+	}
+	test.passed = actual == expected;
+	if(!test.passed){
+		test.detail = FirstDifference(actual, expected);
+	}
+}
+//--
+/*
+	Run one synthetic trace straight from the generator, it must not cause a single error
+*/
+void RunGeneratedCase(TestCase& test)
+{
+	WorkloadGenerator gen(test.workload);
+	Scheduler sch;
+	string discarded;
+	sch.CaptureOutput(&discarded);
+	sch.SetVerbose(false);
+	string_view line;
+	while(gen.Next(line)){
+		sch.RunInstructionString(line);
+	}
+	const SchedulerStats& stats = sch.Stats();
+	test.passed = stats.errors == 0 && stats.completed == test.workload.jobs;
+	test.detail = " (" + to_string(stats.instructions) + " instructions, " + to_string(stats.errors) + " errors, "
+				  + to_string(stats.completed) + "/" + to_string(test.workload.jobs) + " jobs completed)";
+}
+//--
+bool ReadWholeFile(const string& filePath, string& text)
+{
+	FILE* fin = fopen(filePath.c_str(), "rb");
+	if(fin == nullptr){
+		return false;
+	}
+	char chunk[1 << 16];
+	size_t got;
+	while((got = fread(chunk, 1, sizeof(chunk), fin)) > 0){
+		text.append(chunk, got);
+	}
+	fclose(fin);
+	return true;
+}
+//--
+/*
+	Read the options a test is run with, i.e. "-p lottery -r 7", from its .args.txt
+	Only those that change what a trace prints are understood, anything else is a problem and the test is skipped
+*/
+bool ReadTestArgs(const string& filePath, TestCase& test, string& problem)
+{
+	string text;
+	if(!ReadWholeFile(filePath, text)){
+		problem = "its .args.txt could not be read";
+		return false;
+	}
+	vector<string> words;
+	size_t pos = text.find_first_not_of(" \t\r\n");
+	while(pos != string::npos){
+		size_t end = text.find_first_of(" \t\r\n", pos);
+		words.push_back(text.substr(pos, end - pos));
+		pos = text.find_first_not_of(" \t\r\n", end);
+	}
+	for(size_t i = 0; i < words.size(); i++){
+		const string& word = words[i];
+		bool hasValue = i + 1 < words.size();
+		if((word == "-p" || word == "--policy") && hasValue){
+			test.policy = words[++i];
+			if(test.policy != "stride" && test.policy != "lottery" && test.policy != "wfq" && test.policy != "wf2q"){
+				problem = "unknown policy " + test.policy;
+				return false;
+			}
+		}
+		else if((word == "-r" || word == "--seed") && hasValue){
+			test.seed = strtoull(words[++i].c_str(), nullptr, 10);
+		}
+		else if((word == "-b" || word == "--blocked-order") && hasValue){
+			const string& order = words[++i];
+			if(order != "name" && order != "time"){
+				problem = "unknown blocked order " + order;
+				return false;
+			}
+			test.blockedOrder = (order == "time") ? BLOCKED_BY_TIME : BLOCKED_BY_NAME;
+		}
+		else if(word == "-q" || word == "--quiet" || word == "-s" || word == "--summary"){
+			test.summaryOnly = true;
+		}
+		else if(word == "-l" || word == "--latency"){
+			test.latency = true;
+		}
+		else{
+			problem = "needs " + word + ", which runtests doesn't handle";
+			return false;
+		}
+	}
+	if(test.latency && (test.policy == "wfq" || test.policy == "wf2q")){
+		problem = "asks " + test.policy + " for latency numbers, which it doesn't keep";
+		return false;
+	}
+	return true;
+}
+//--
+/*
+	Describe the first line where the output differs from what was expected
+*/
+string FirstDifference(const string& actual, const string& expected)
+{
+	size_t line = 1;
+	size_t pos = 0;
+	while(pos < actual.size() && pos < expected.size() && actual[pos] == expected[pos]){
+		if(actual[pos] == '\n'){
+			line++;
+		}
+		pos++;
+	}
+	size_t lineStart = (pos > 0) ? actual.rfind('\n', pos - 1) : string::npos;
+	lineStart = (lineStart == string::npos) ? 0 : lineStart + 1;
+	auto lineAt = [lineStart](const string& text){
+		if(lineStart >= text.size()){
+			return string("<end of output>");
+		}
+		return text.substr(lineStart, text.find('\n', lineStart) - lineStart);
+	};
+	return " (line " + to_string(line) + ": got \"" + lineAt(actual) + "\", expected \"" + lineAt(expected) + "\")";
+}
+//--
+/*
+	Read in the command line options
+	-d DIR		directory holding the NAME.input.txt / NAME.expected_output.txt pairs (default tests)
+	-t N		worker threads (default: one per core)
+	-g N		number of generated traces to run as well (default 8)
+	-j N		jobs in each generated trace (default 20000)
+*/
+void HandleOptions(int argc, char* argv[], string& testDir, unsigned& threads, uint64_t& generated, uint64_t& jobs)
+{
+	int c;
+	while ((c = getopt(argc, argv, "d:t:g:j:")) != -1)
+	{
+		switch(c)
+		{
+			case 'd':
+			{
+				testDir = string(optarg);
+				break;
+			}
+			case 't':
+			{
+				threads = max(1u, unsigned(strtoul(optarg, nullptr, 10)));
+				break;
+			}
+			case 'g':
+			{
+				generated = strtoull(optarg, nullptr, 10);
+				break;
+			}
+			case 'j':
+			{
+				jobs = max(1ull, strtoull(optarg, nullptr, 10));
+				break;
+			}
+			default:
+			{
+				PrintUsage();
+				exit(1);
+			}
+		}
+	}
+}
+//--
+void PrintUsage()
+{
+	fprintf(stderr, "Usage: runtests [options]\n");
+	fprintf(stderr, "-d DIR	(OPT)	directory of NAME.input.txt & NAME.expected_output.txt pairs (default tests)\n");
+	fprintf(stderr, "-t N	(OPT)	worker threads (default one per core)\n");
+	fprintf(stderr, "-g N	(OPT)	generated traces to run as well (default 8)\n");
+	fprintf(stderr, "-j N	(OPT)	jobs in each generated trace (default 20000)\n");
+}
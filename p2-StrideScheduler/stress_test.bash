@@ -0,0 +1,66 @@
+#!/bin/bash
+
+# stress_test.bash -a prog -n interrupts
+# -a prog - optional - if given is the name of the program to execute
+#           if not given, a.out is assumed.
+# -n interrupts - optional - number of quanta to run, 1500000 if not given
+#
+# Runs two groups (1 & 2 tickets) long enough for their passes to go well past 2^32
+# (the old 32 bit passes wrapped there, and the old INT_MAX compare broke at 2^31)
+# and checks the groups still split the CPU 1:2 to within a quantum.
+
+temp_trace="_stress_trace.txt"
+temp_csv="_stress_fairness.csv"
+prog="./a.out"
+interrupts=1500000
+while getopts "a:n:" opt
+do
+	case ${opt} in
+	a )
+		prog=$OPTARG
+		;;
+	n )
+		interrupts=$OPTARG
+		;;
+	\? ) # prints command line options
+		echo "Usage:"
+		echo "-a <prog>       [ optional - if missing a.out is assumed"
+		echo "-n <interrupts> [ optional - if missing 1500000 is assumed"
+		exit 0
+		;;
+	esac
+done
+
+if [ ! -x $prog ]
+then
+	echo $prog "does not exist or is not an executable"
+	exit 1
+fi
+
+{
+	echo "group,g1,1"
+	echo "group,g2,2"
+	echo "newjob,A1,1,g1"
+	echo "newjob,A2,2,g1"
+	echo "newjob,B1,1,g2"
+	echo "newjob,B2,2,g2"
+	yes interrupt | head -n $interrupts
+} > $temp_trace
+
+echo "Stress trace:         " $interrupts "interrupts, group strides 10000 & 5000"
+$prog -q -f $temp_csv $temp_trace | grep "Errors:"
+# Sum the quanta received by each group
+read g1 g2 < <(awk -F, 'NR > 1 { q[$2] += $5 } END { print q["g1"] + 0, q["g2"] + 0 }' $temp_csv)
+echo "Quanta received:       g1" $g1 " g2" $g2
+echo "Expected:              g1" $((interrupts / 3)) " g2" $((interrupts * 2 / 3))
+a=1
+if [ $((g1 + g2)) -eq $interrupts ] && [ $((g1 * 3 - interrupts)) -ge -3 ] && [ $((g1 * 3 - interrupts)) -le 3 ]
+then
+	a=0
+	echo "PASSED"
+else
+	echo "FAILED"
+fi
+echo "Test finished"
+rm -f $temp_trace $temp_csv
+exit $a
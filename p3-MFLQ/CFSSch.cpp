@@ -0,0 +1,442 @@
+#include "CFSSch.hpp"
+
+using namespace std;
+
+CFSSch::CFSSch()
+{
+    currRunningJob = nullptr;
+    minVruntime = 0;
+    nextOrder = 0;
+    verbose = true;
+}
+//--
+CFSSch::~CFSSch()
+{
+    if (currRunningJob != nullptr)
+    {
+        jobPool.Delete(currRunningJob);
+        currRunningJob = nullptr;
+    }
+    for (Job *job : runnables)
+    {
+        jobPool.Delete(job);
+    }
+    runnables.clear();
+    while (blocked.size() > 0)
+    {
+        jobPool.Delete(blocked.PopFront());
+    }
+}
+//--
+/*
+    Map in the file via the path specified
+    And execute the instruction found on each line
+*/
+void CFSSch::RunInstructionFile(const std::string &filePath)
+{
+    TraceReader trace;
+    if (!trace.Open(filePath.c_str()))
+    {
+        fprintf(stderr, "Input file failed to open.\n");
+        out.Flush();
+        exit(1);
+    }
+    TraceCommand cmd;
+    while (trace.Next(cmd))
+    {
+        RunCommand(cmd);
+    }
+}
+//--
+void CFSSch::RunInstructionString(std::string_view line)
+{
+    TraceCommand cmd;
+    if (ParseTraceLine(line, cmd))
+    {
+        RunCommand(cmd);
+    }
+}
+//--
+/*
+    Given an instruction already parsed by the trace parser, run the desired instruction
+    The opcodes are MLFQSch's, with the same meaning, except that epoch does nothing:
+    no job is ever demoted, so there is nothing to lift.
+*/
+void CFSSch::RunCommand(const TraceCommand &cmd)
+{
+    stats.instructions++;
+    switch (cmd.opcode)
+    {
+    case NEWJOB:
+    {
+        CreateNewJob(cmd.arg1);
+        break;
+    }
+    case INTERRUPT:
+    {
+        if (FindCpu(cmd.arg1))
+        {
+            Interrupt();
+        }
+        break;
+    }
+    case BLOCK:
+    {
+        if (FindCpu(cmd.arg1))
+        {
+            Block();
+        }
+        break;
+    }
+    case UNBLOCK:
+    {
+        UnBlock(cmd.arg1);
+        break;
+    }
+    case FINISH:
+    {
+        if (FindCpu(cmd.arg1))
+        {
+            FinishJob();
+        }
+        break;
+    }
+    case RUNNING:
+    {
+        PrintRunningTask();
+        break;
+    }
+    case RUNNABLE:
+    {
+        PrintRunnables();
+        break;
+    }
+    case BLOCKED:
+    {
+        PrintBlockedTasks();
+        break;
+    }
+    case EPOCH:
+    {
+        stats.epochs++;
+        break;
+    }
+    case INVALID:
+    default:
+    {
+        break;
+    }
+    }
+}
+//--
+/*
+    Only CPU 0 is modelled, an argument that is not all digits is a comment as it is for MLFQSch
+*/
+bool CFSSch::FindCpu(string_view text)
+{
+    uint32_t cpuIndex = 0;
+    from_chars_result result = from_chars(text.data(), text.data() + text.size(), cpuIndex);
+    if (text.size() == 0 || result.ptr != text.data() + text.size())
+    {
+        return true;
+    }
+    if (result.ec != errc() || cpuIndex != 0)
+    {
+        Report("Error. CPU: ", text, " does not exist.\n");
+        stats.errors++;
+        return false;
+    }
+    return true;
+}
+//--
+/*
+    Move minVruntime up to the smallest virtual runtime of the running job & the leftmost runnable
+*/
+void CFSSch::UpdateMinVruntime()
+{
+    uint64_t smallest = minVruntime;
+    bool any = false;
+    if (currRunningJob != nullptr)
+    {
+        smallest = currRunningJob->vruntime;
+        any = true;
+    }
+    if (runnables.size() > 0)
+    {
+        uint64_t leftmost = (*runnables.begin())->vruntime;
+        smallest = (any && smallest < leftmost) ? smallest : leftmost;
+        any = true;
+    }
+    if (any && smallest > minVruntime)
+    {
+        minVruntime = smallest;
+    }
+}
+//--
+/*
+    Put a job in the tree, behind any job with the same virtual runtime
+*/
+void CFSSch::MakeRunnable(Job *job)
+{
+    job->order = nextOrder++;
+    job->readySince = stats.interrupts;
+    runnables.insert(job);
+}
+//--
+/*
+    OPCODE: newjob
+    A new job starts at minVruntime, level with the fairest job in the system.
+    It does not cause a rescheduling unless the system was idle.
+*/
+void CFSSch::CreateNewJob(string_view name)
+{
+    Job *nJob = jobPool.New(name, minVruntime, stats.interrupts);
+    MakeRunnable(nJob);
+    jobIndex[nJob->name] = nJob;
+    stats.newJobs++;
+
+    Report("New job: ", nJob->name, " added.\n");
+
+    if (currRunningJob == nullptr)
+    {
+        ScheduleNextJob();
+    }
+}
+//--
+/*
+    Run the leftmost job of the tree, the one that has had the least CPU
+*/
+void CFSSch::ScheduleNextJob()
+{
+    if (runnables.size() > 0)
+    {
+        Job *job = *runnables.begin();
+        runnables.erase(runnables.begin());
+        uint64_t wait = stats.interrupts - job->readySince;
+        job->longestWait = (wait > job->longestWait) ? wait : job->longestWait;
+        if (!job->started)
+        {
+            job->started = true;
+            latencies.response.Record(stats.interrupts - job->arrival);
+        }
+        currRunningJob = job;
+        stats.schedules++;
+        Report("Job: ", job->name, " scheduled.\n");
+    }
+    else
+    {
+        currRunningJob = nullptr;
+        stats.idles++;
+        Report("System is idle.\n");
+    }
+    UpdateMinVruntime();
+}
+//--
+/*
+    OPCODE: finish
+    The running job leaves the system, it is an error if the system is idle
+*/
+void CFSSch::FinishJob()
+{
+    if (currRunningJob != nullptr)
+    {
+        Job *job = currRunningJob;
+        Report("Job: ", job->name, " completed.\n");
+        stats.completed++;
+        latencies.turnaround.Record(stats.interrupts - job->arrival);
+        latencies.longestWait.Record(job->longestWait);
+        jobIndex.erase(job->name);
+        jobPool.Delete(job);
+        currRunningJob = nullptr;
+        ScheduleNextJob();
+    }
+    else
+    {
+        Report("Error. System is idle.\n");
+        stats.errors++;
+    }
+}
+//--
+/*
+    OPCODE: interrupt
+    The running job has run for one more tick.
+    It keeps the CPU while it is still strictly the fairest, otherwise it goes back in the tree and the leftmost runs.
+*/
+void CFSSch::Interrupt()
+{
+    if (currRunningJob != nullptr)
+    {
+        stats.interrupts++;
+        currRunningJob->vruntime++;
+        if (runnables.size() > 0 && (*runnables.begin())->vruntime <= currRunningJob->vruntime)
+        {
+            MakeRunnable(currRunningJob);
+            currRunningJob = nullptr;
+            ScheduleNextJob();
+        }
+        else
+        {
+            UpdateMinVruntime();
+        }
+    }
+    else
+    {
+        Report("Error. System is idle.\n");
+        stats.errors++;
+    }
+}
+//--
+/*
+    OPCODE: block
+    The running job leaves the tree for the blocked list, keeping its virtual runtime
+*/
+void CFSSch::Block()
+{
+    if (currRunningJob != nullptr)
+    {
+        Job *bljb = currRunningJob;
+        bljb->blocked = true;
+        blocked.PushBack(bljb);
+        stats.blocks++;
+        Report("Job: ", bljb->name, " blocked.\n");
+        currRunningJob = nullptr;
+        ScheduleNextJob();
+    }
+    else
+    {
+        Report("Error. System is idle.\n");
+        stats.errors++;
+    }
+}
+//--
+/*
+    OPCODE: unblock
+    The named job wakes up, it is an error if it was not blocked.
+    It comes back no further behind minVruntime than CFS_SLEEPER_CREDIT, and preempts the running job if it is then strictly behind it.
+*/
+void CFSSch::UnBlock(string_view name)
+{
+    unordered_map<string_view, Job*>::iterator found = jobIndex.find(name);
+    if (found == jobIndex.end() || !found->second->blocked)
+    {
+        Report("Error. Job: ", name, " not blocked.\n");
+        stats.errors++;
+        return;
+    }
+    Job *job = found->second;
+    blocked.Remove(job);
+    job->blocked = false;
+    uint64_t floor = (minVruntime > CFS_SLEEPER_CREDIT) ? minVruntime - CFS_SLEEPER_CREDIT : 0;
+    job->vruntime = (job->vruntime > floor) ? job->vruntime : floor;
+    MakeRunnable(job);
+    stats.unblocks++;
+    Report("Job: ", job->name, " has unblocked.\n");
+
+    if (currRunningJob != nullptr && job->vruntime < currRunningJob->vruntime)
+    {
+        stats.preemptions++;
+        MakeRunnable(currRunningJob);
+        currRunningJob = nullptr;
+    }
+    if (currRunningJob == nullptr)
+    {
+        ScheduleNextJob();
+    }
+    else
+    {
+        UpdateMinVruntime();
+    }
+}
+//--
+void CFSSch::PrintJob(const Job *job)
+{
+    Report(Column(job->name, 8), job->vruntime, '\n');
+}
+//--
+/*
+    OPCODE: runnable
+    The runnables in the order they would be scheduled, an in order walk of the tree
+        Runnables:
+        NAME    VRUNTIME
+        B       12
+        A       14
+*/
+void CFSSch::PrintRunnables()
+{
+    if (!verbose)
+    {
+        return; // Nothing would be printed, don't walk the tree for it
+    }
+    Report("Runnables:\n");
+    if (runnables.size() == 0)
+    {
+        Report("None\n");
+        return;
+    }
+    Report("NAME    VRUNTIME\n");
+    for (const Job *job : runnables)
+    {
+        PrintJob(job);
+    }
+}
+//--
+void CFSSch::PrintRunningTask()
+{
+    if (!verbose)
+    {
+        return;
+    }
+    Report("Running:\n");
+    if (currRunningJob == nullptr)
+    {
+        Report("None\n");
+        return;
+    }
+    Report("NAME    VRUNTIME\n");
+    PrintJob(currRunningJob);
+}
+//--
+/*
+    OPCODE: blocked
+    The blocked jobs, in the order they blocked
+*/
+void CFSSch::PrintBlockedTasks()
+{
+    if (!verbose)
+    {
+        return;
+    }
+    Report("Blocked:\n");
+    if (blocked.size() == 0)
+    {
+        Report("None\n");
+        return;
+    }
+    Report("NAME    VRUNTIME\n");
+    for (const Job *job : blocked)
+    {
+        PrintJob(job);
+    }
+}
+//--
+void CFSSch::SetVerbose(const bool& on)
+{
+    verbose = on;
+}
+//--
+void CFSSch::PrintLatency()
+{
+    WriteLatencies(out, latencies);
+}
+//--
+/*
+    Print the aggregate statistics gathered over the whole run
+    along with what was left in the system at the end
+*/
+void CFSSch::PrintSummary()
+{
+    stats.Print(out, runnables.size(), (currRunningJob != nullptr) ? 1 : 0, blocked.size());
+    out.Write(Column("Min vruntime:", 16), minVruntime, '\n');
+    out.Flush();
+}
+//--
@@ -0,0 +1,107 @@
+#pragma once
+#include <stdio.h>
+#include <string>
+#include <string_view>
+#include <set>
+#include <unordered_map>
+#include "TraceParser.hpp"
+#include "IntrusiveList.hpp"
+#include "ObjectPool.hpp"
+#include "InlineName.hpp"
+#include "OutputSink.hpp"
+#include "JobLatencies.hpp"
+#include "SchedulerStats.hpp"
+
+#define CFS_SLEEPER_CREDIT 3 // Ticks a waking job may be placed behind minVruntime, half a 6 tick target latency
+
+/*
+    Completely fair scheduling, driven by the same trace language as MLFQSch (epoch is ignored)
+
+    Every job has a virtual runtime: the interrupts (ticks) it has run for, all jobs weighing the same.
+    Runnables wait in a red-black tree (std::set) ordered by virtual runtime, so the next job to run is its leftmost,
+    and adding or removing one costs O(log n) however many jobs there are.
+    The running job gives way at an interrupt once a runnable's virtual runtime is no greater than its own.
+    minVruntime only ever moves forward, to the smallest virtual runtime of the running job & the runnables:
+    a new job starts at it, and a waking job is brought up to no further behind it than CFS_SLEEPER_CREDIT
+    (a short sleeper gets a little credit, a long sleep banks no more than that),
+    preempting the running job if it is then strictly behind.
+    One CPU is modelled: CPU 0 is the only one an opcode may name.
+*/
+class CFSSch{
+public:
+    CFSSch();
+    ~CFSSch();
+    void RunInstructionFile(const std::string& filePath);
+    void RunInstructionString(std::string_view line);
+    void RunCommand(const TraceCommand& cmd);
+    void SetVerbose(const bool& on);
+    void PrintSummary();
+    void PrintLatency();
+private:
+    struct Job
+    {
+        Job(std::string_view n, const uint64_t& v, const uint64_t& now) :
+            name(n), vruntime(v), order(0), blocked(false), started(false),
+            arrival(now), readySince(now), longestWait(0) {}
+
+        InlineName name;
+        uint64_t vruntime;   // Ticks run, the tree's key
+        uint64_t order;      // When it was last added to the tree, so equal virtual runtimes take turns
+        bool blocked;        // On the blocked list
+        bool started;        // Has run at least once
+        uint64_t arrival;    // Tick it arrived on
+        uint64_t readySince; // Tick it last became runnable
+        uint64_t longestWait; // Longest it has sat runnable before running
+        ListLinks<Job> blockedLinks;
+    };
+
+    /*
+        Smallest virtual runtime first, the one added to the tree first on a tie
+    */
+    struct ByVruntime
+    {
+        bool operator()(const Job* a, const Job* b) const
+        {
+            return (a->vruntime != b->vruntime) ? a->vruntime < b->vruntime : a->order < b->order;
+        }
+    };
+
+    // Methods
+    void CreateNewJob(std::string_view name);
+    void ScheduleNextJob();
+    void MakeRunnable(Job* job);
+    void UpdateMinVruntime();
+    bool FindCpu(std::string_view text);
+
+    void FinishJob();
+    void Interrupt();
+    void Block();
+    void UnBlock(std::string_view name);
+    void PrintRunnables();
+    void PrintRunningTask();
+    void PrintBlockedTasks();
+    void PrintJob(const Job* job);
+
+    // Per event output, dropped entirely when not verbose
+    template <typename... Args>
+    void Report(const Args&... args)
+    {
+        if (verbose)
+        {
+            out.Write(args...);
+        }
+    }
+
+    // Data Members
+    ObjectPool<Job> jobPool;
+    std::set<Job*, ByVruntime> runnables;   // Red-black tree, the leftmost runs next
+    IntrusiveList<Job, &Job::blockedLinks> blocked; // In the order they blocked
+    std::unordered_map<std::string_view, Job*> jobIndex; // Every job in the system by name, keys view the job's own name
+    Job* currRunningJob;
+    uint64_t minVruntime;
+    uint64_t nextOrder;
+    bool verbose;
+    SchedulerStats stats;
+    JobLatencies latencies;
+    OutputSink out;
+};
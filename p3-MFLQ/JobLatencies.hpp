@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+#include "LatencyHistogram.hpp"
+#include "OutputSink.hpp"
+
+/*
+    How long jobs waited, in ticks: a trace's only clock is its interrupts, so one tick is one interrupt (on any CPU)
+    response is arrival to first run and turnaround arrival to finish, for every job that finished.
+    longestWait is the longest each finished job sat runnable before it next ran, i.e. how close it came to starving.
+    Kept the same way by every policy, so they can be compared on one trace.
+*/
+struct JobLatencies
+{
+    LatencyHistogram response;
+    LatencyHistogram turnaround;
+    LatencyHistogram longestWait;
+};
+
+/*
+    The latency table printed at exit (--latency), whichever policy kept it
+*/
+inline void WriteLatencies(OutputSink& out, const JobLatencies& latencies)
+{
+    out.Write("Latency (ticks):\n");
+    out.Write(Column("", 14), Column("COUNT", 10), Column("P50", 10), Column("P99", 10), Column("P999", 10), "MAX\n");
+    const char* names[] = {"Response", "Turnaround", "Longest wait"};
+    const LatencyHistogram* histograms[] = {&latencies.response, &latencies.turnaround, &latencies.longestWait};
+    for (int i = 0; i < 3; i++)
+    {
+        const LatencyHistogram& h = *histograms[i];
+        out.Write(Column(names[i], 14), Column(h.Count(), 10), Column(h.Percentile(0.5), 10),
+                  Column(h.Percentile(0.99), 10), Column(h.Percentile(0.999), 10), h.Max(), '\n');
+    }
+    out.Flush();
+}
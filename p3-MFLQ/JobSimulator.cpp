@@ -0,0 +1,254 @@
+#include "JobSimulator.hpp"
+#include <stdlib.h>
+#include <charconv>
+
+using namespace std;
+
+JobSimulator::JobSimulator(const SimulationOptions& options, MLFQSch& scheduler) : opts(options), sch(scheduler), rng(options.seed)
+{
+    if (opts.profiles.size() == 0)
+    {
+        opts.profiles.push_back(JobProfile{"interactive", 3, 2, 20, 10});
+        opts.profiles.push_back(JobProfile{"batch", 1, 50, 2, 3});
+    }
+    totalWeight = 0;
+    for (const JobProfile& profile : opts.profiles)
+    {
+        totalWeight += profile.weight;
+    }
+    results.resize(opts.profiles.size());
+    for (uint32_t cpu = 0; cpu < sch.CpuCount(); cpu++)
+    {
+        cpuNames.push_back(to_string(cpu));
+    }
+    ranThisTick.resize(cpuNames.size());
+    jobs.reserve(opts.jobs);
+    finished = 0;
+    elapsed = 0;
+}
+//--
+/*
+    Split "NAME:WEIGHT:CPU:IO:BURSTS" into a profile
+*/
+bool ParseJobProfile(const string& spec, SimulationOptions& opts)
+{
+    vector<string> parts = SplitSpec(spec);
+    if (parts.size() != 5 || parts[0].size() == 0)
+    {
+        return false;
+    }
+    JobProfile profile;
+    profile.name = parts[0];
+    profile.weight = atof(parts[1].c_str());
+    profile.meanCpuBurst = atof(parts[2].c_str());
+    profile.meanIoBurst = atof(parts[3].c_str());
+    profile.meanBursts = atof(parts[4].c_str());
+    if (profile.weight <= 0 || profile.meanCpuBurst < 1 || profile.meanIoBurst < 1 || profile.meanBursts < 1)
+    {
+        return false;
+    }
+    opts.profiles.push_back(profile);
+    return true;
+}
+//--
+void JobSimulator::Run()
+{
+    if (opts.jobs == 0)
+    {
+        return;
+    }
+    wheel.Schedule(0, Event{ARRIVAL, 0});
+    if (opts.epochInterval > 0)
+    {
+        wheel.Schedule(opts.epochInterval, Event{EPOCH_DUE, 0});
+    }
+    while (finished < opts.jobs)
+    {
+        uint64_t now = wheel.Now();
+        due.clear();
+        wheel.Tick(due);
+        for (const Event& event : due)
+        {
+            switch (event.type)
+            {
+                case ARRIVAL:
+                {
+                    Arrive(now);
+                    break;
+                }
+                case IO_DONE:
+                {
+                    jobs[event.id].readySince = now;
+                    Feed(UNBLOCK, JobName(event.id));
+                    break;
+                }
+                case EPOCH_DUE:
+                {
+                    Feed(EPOCH);
+                    wheel.Schedule(now + opts.epochInterval, Event{EPOCH_DUE, 0});
+                    break;
+                }
+            }
+        }
+        RunTick(now);
+    }
+    elapsed = wheel.Now();
+}
+//--
+/*
+    A new job arrives with a profile picked by weight, and the next arrival is put on the wheel
+*/
+void JobSimulator::Arrive(const uint64_t& now)
+{
+    double pick = rng.Uniform() * totalWeight;
+    uint32_t profile = 0;
+    while (profile + 1 < opts.profiles.size() && pick >= opts.profiles[profile].weight)
+    {
+        pick -= opts.profiles[profile].weight;
+        profile++;
+    }
+    const JobProfile& shape = opts.profiles[profile];
+    SimJob job;
+    job.profile = profile;
+    job.cpuLeft = rng.Geometric(shape.meanCpuBurst);
+    job.burstsLeft = rng.Geometric(shape.meanBursts);
+    job.arrival = now;
+    job.readySince = now;
+    job.longestWait = 0;
+    job.started = false;
+    jobs.push_back(job);
+    Feed(NEWJOB, JobName(jobs.size() - 1));
+
+    if (jobs.size() < opts.jobs)
+    {
+        wheel.Schedule(now + rng.Geometric(opts.meanArrival), Event{ARRIVAL, 0});
+    }
+}
+//--
+/*
+    Every busy CPU's job uses up one tick, and the scheduler hears how that tick ended
+    First, a job back on a CPU with its burst already used up blocks or finishes before the tick starts.
+    Who ran this tick is then settled before any of it is fed in:
+    a CPU that picks up a job part way through (i.e. by stealing) only runs it from the next tick.
+*/
+void JobSimulator::RunTick(const uint64_t& now)
+{
+    for (uint32_t cpu = 0; cpu < cpuNames.size(); cpu++)
+    {
+        uint64_t id = RunningJob(cpu);
+        while (id != NO_JOB && jobs[id].cpuLeft == 0)
+        {
+            EndBurst(cpu, id, now);
+            id = RunningJob(cpu);
+        }
+        ranThisTick[cpu] = id;
+    }
+    for (uint32_t cpu = 0; cpu < cpuNames.size(); cpu++)
+    {
+        uint64_t id = ranThisTick[cpu];
+        if (id == NO_JOB)
+        {
+            continue;
+        }
+        SimJob& job = jobs[id];
+        ProfileResults& result = results[job.profile];
+        if (!job.started)
+        {
+            job.started = true;
+            result.response.Record(now - job.arrival);
+        }
+        uint64_t wait = now - job.readySince;
+        job.longestWait = (wait > job.longestWait) ? wait : job.longestWait;
+        job.readySince = now + 1; // Runnable again from the end of this tick, unless it blocks
+
+        job.cpuLeft--;
+        Feed(INTERRUPT, cpuNames[cpu]);
+        if (job.cpuLeft == 0 && RunningJob(cpu) == id)
+        {
+            EndBurst(cpu, id, now + 1);
+        }
+    }
+}
+//--
+/*
+    The job running on the CPU, NO_JOB when it is idle
+*/
+uint64_t JobSimulator::RunningJob(const uint32_t& cpu)
+{
+    string_view name = sch.RunningJobName(cpu);
+    uint64_t id = NO_JOB;
+    if (name.size() > 0)
+    {
+        from_chars(name.data() + 1, name.data() + name.size(), id);
+    }
+    return id;
+}
+//--
+/*
+    The running job's CPU burst is over as of when: it blocks for its next I/O burst, or finishes after its last
+*/
+void JobSimulator::EndBurst(const uint32_t& cpu, const uint64_t& id, const uint64_t& when)
+{
+    SimJob& job = jobs[id];
+    if (job.burstsLeft > 1)
+    {
+        const JobProfile& shape = opts.profiles[job.profile];
+        job.burstsLeft--;
+        job.cpuLeft = rng.Geometric(shape.meanCpuBurst);
+        wheel.Schedule(when + rng.Geometric(shape.meanIoBurst), Event{IO_DONE, id});
+        Feed(BLOCK, cpuNames[cpu]);
+    }
+    else
+    {
+        ProfileResults& result = results[job.profile];
+        result.turnaround.Record(when - job.arrival);
+        result.longestWait.Record(job.longestWait);
+        finished++;
+        Feed(FINISH, cpuNames[cpu]);
+    }
+}
+//--
+/*
+    Run one opcode through the scheduler, just as if it had been read from a trace
+*/
+void JobSimulator::Feed(const OPCODE& opcode, string_view arg)
+{
+    TraceCommand cmd;
+    cmd.opcode = opcode;
+    cmd.arg1 = arg;
+    cmd.arg2 = -1;
+    cmd.arg2Text = string_view();
+    cmd.arg3 = string_view();
+    sch.RunCommand(cmd);
+}
+//--
+/*
+    "J" followed by the job's id, valid until the next call
+*/
+string_view JobSimulator::JobName(const uint64_t& id)
+{
+    nameBuffer[0] = 'J';
+    char* end = to_chars(nameBuffer + 1, nameBuffer + sizeof(nameBuffer), id).ptr;
+    return string_view(nameBuffer, end - nameBuffer);
+}
+//--
+void JobSimulator::PrintResults()
+{
+    sch.FlushOutput();
+    OutputSink out;
+    out.Write("Simulation:\n");
+    out.Write(Column("Jobs:", 16), jobs.size(), '\n');
+    out.Write(Column("Ticks:", 16), elapsed, '\n');
+    out.Write(Column("PROFILE", 14), Column("JOBS", 10), Column("RESP P50", 10), Column("RESP P99", 10),
+              Column("TURN P50", 10), Column("TURN P99", 10), Column("WAIT P99", 10), "WAIT MAX\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const ProfileResults& result = results[i];
+        out.Write(Column(opts.profiles[i].name, 14), Column(result.turnaround.Count(), 10),
+                  Column(result.response.Percentile(0.5), 10), Column(result.response.Percentile(0.99), 10),
+                  Column(result.turnaround.Percentile(0.5), 10), Column(result.turnaround.Percentile(0.99), 10),
+                  Column(result.longestWait.Percentile(0.99), 10), result.longestWait.Max(), '\n');
+    }
+    out.Flush();
+}
+//--
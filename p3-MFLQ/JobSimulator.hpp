@@ -0,0 +1,119 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "MLFQSch.hpp"
+#include "TimingWheel.hpp"
+#include "LatencyHistogram.hpp"
+#include "Random.hpp"
+
+/*
+    Time driven simulation: jobs described by burst distributions rather than a trace
+
+    Every job alternates CPU bursts and I/O bursts, drawn from its profile:
+        NAME:WEIGHT:CPU:IO:BURSTS
+    WEIGHT is how likely a new job is to have this profile (relative to the others),
+    CPU and IO the mean length in ticks of each CPU & I/O burst, and BURSTS the mean number of CPU bursts.
+    All three are geometric, so they are never below 1.
+
+    Time moves one tick at a time. On each tick:
+        arrivals, I/O completions & epochs due now are fed to the scheduler (newjob / unblock / epoch)
+        then every busy CPU's job uses one tick of its CPU burst and is fed an interrupt, so every tick run is charged,
+        followed by a block once the burst is over (its I/O completion goes on the timing wheel) or a finish after its last burst.
+    If that interrupt ended the job's quantum and it lost the CPU, the block / finish waits until it is next scheduled,
+    and is fed at the start of that tick before anything runs.
+    Burst ends are counted down tick by tick rather than put on the wheel: a job only gets through its burst while it runs,
+    so when it ends depends on scheduling that hasn't happened yet.
+    The scheduler sees exactly the opcodes a trace would give it, there is just no trace.
+*/
+
+struct JobProfile
+{
+    std::string name;
+    double weight = 1;
+    double meanCpuBurst = 4;
+    double meanIoBurst = 8;
+    double meanBursts = 4;
+};
+
+struct SimulationOptions
+{
+    uint64_t jobs = 1000;           // Jobs that arrive over the whole run
+    double meanArrival = 64;        // Mean ticks between arrivals (at least 1)
+    uint64_t epochInterval = 100;   // Ticks between epochs, 0 for none
+    std::vector<JobProfile> profiles; // Default: an interactive and a batch profile
+    uint64_t seed = 1;
+};
+
+/*
+    Parse a profile of the form NAME:WEIGHT:CPU:IO:BURSTS and add it to the options
+    Returns false if the spec is malformed
+*/
+bool ParseJobProfile(const std::string& spec, SimulationOptions& opts);
+
+class JobSimulator
+{
+public:
+    JobSimulator(const SimulationOptions& options, MLFQSch& scheduler);
+
+    /*
+        Run until every job has arrived and finished
+    */
+    void Run();
+
+    /*
+        Print the simulated time taken, and per profile response time (arrival to first run),
+        turnaround (arrival to finish) and the longest each job waited to run while it was runnable
+    */
+    void PrintResults();
+
+private:
+    enum EVENT_TYPE {ARRIVAL, IO_DONE, EPOCH_DUE};
+    static const uint64_t NO_JOB = UINT64_MAX;
+
+    struct Event
+    {
+        EVENT_TYPE type;
+        uint64_t id;    // The job, for IO_DONE
+    };
+
+    struct SimJob
+    {
+        uint32_t profile;
+        uint64_t cpuLeft;       // Ticks left in its current CPU burst
+        uint64_t burstsLeft;    // CPU bursts left, counting the current one
+        uint64_t arrival;
+        uint64_t readySince;    // When it last became runnable (arrived, its I/O was done or it last ran)
+        uint64_t longestWait;
+        bool started;
+    };
+
+    struct ProfileResults
+    {
+        LatencyHistogram response;
+        LatencyHistogram turnaround;
+        LatencyHistogram longestWait;
+    };
+
+    void Arrive(const uint64_t& now);
+    void RunTick(const uint64_t& now);
+    uint64_t RunningJob(const uint32_t& cpu);
+    void EndBurst(const uint32_t& cpu, const uint64_t& id, const uint64_t& when);
+    void Feed(const OPCODE& opcode, std::string_view arg = std::string_view());
+    std::string_view JobName(const uint64_t& id);
+
+    SimulationOptions opts;
+    MLFQSch& sch;
+    TimingWheel<Event> wheel;
+    std::vector<SimJob> jobs;           // Indexed by id, job J<id>
+    std::vector<ProfileResults> results; // One per profile
+    std::vector<std::string> cpuNames;  // "0", "1", ... to aim opcodes at each CPU
+    std::vector<uint64_t> ranThisTick;  // The job each CPU ran this tick, NO_JOB when idle
+    std::vector<Event> due;
+    double totalWeight;
+    char nameBuffer[24];
+    SplitMix64 rng;
+    uint64_t finished;
+    uint64_t elapsed;                   // Ticks simulated
+};
@@ -1,76 +1,87 @@
 #include "MLFQSch.hpp"
+#include <stdlib.h>
+#include <algorithm>
 
 using namespace std;
 
-MLFQSch::MLFQSch()
+MLFQSch::MLFQSch(const MLFQConfig& config)
 {
-    systemRunning = false;
-    currRunningJob = nullptr;
+    verbose = true;
+    epochGeneration = 0;
+    recordTransitions = false;
 
-    for (size_t queue = 0; queue < NUMBER_OF_QUEUES; queue++)
+    levelCount = config.levels;
+    levelStats.reset(new LevelStats[levelCount]);
+    cpuCount = config.cpus;
+    cpus.reset(new Cpu[cpuCount]);
+    for (uint32_t cpuIndex = 0; cpuIndex < cpuCount; cpuIndex++)
     {
-        FeedbackQueue *fbq = new FeedbackQueue();
-        allQueues.push_back(fbq);
+        Cpu &cpu = cpus[cpuIndex];
+        cpu.allQueues.reset(new FeedbackQueue[levelCount]);
+        uint32_t quantum = 1;
+        uint32_t allotment = 1;
+        for (uint32_t queue = 0; queue < levelCount; queue++)
+        {
+            // Levels past the end of either list repeat its last value
+            quantum = (queue < config.quanta.size()) ? config.quanta[queue] : quantum;
+            allotment = (queue < config.allotments.size()) ? config.allotments[queue] : allotment;
+            cpu.allQueues[queue].quantum = quantum;
+            cpu.allQueues[queue].allotment = allotment;
+        }
     }
 }
 //--
 MLFQSch::~MLFQSch()
 {
-    // Incase we have
-    if (currRunningJob != nullptr)
+    for (uint32_t cpuIndex = 0; cpuIndex < cpuCount; cpuIndex++)
     {
-        delete currRunningJob;
-        currRunningJob = nullptr;
-    }
+        Cpu &cpu = cpus[cpuIndex];
+        // Incase we have
+        if (cpu.currRunningJob != nullptr)
+        {
+            jobPool.Delete(cpu.currRunningJob);
+            cpu.currRunningJob = nullptr;
+        }
 
-    // Delete all of the queues
-    for (auto que : allQueues)
-    {
-        // Check for runnables to delete
-        if (que->runnables.size() > 0)
+        // Delete the jobs left in each queue (the queues go with allQueues)
+        for (uint32_t queueIndex = 0; queueIndex < levelCount; queueIndex++)
         {
-            for (auto job : que->runnables)
+            FeedbackQueue *que = &cpu.allQueues[queueIndex];
+            // Check for runnables to delete
+            while (que->runnables.size() > 0)
             {
-                delete job;
+                jobPool.Delete(que->runnables.PopFront());
             }
-        }
 
-        // Check for blocked jobs to delete
-        if (que->blocked.size() > 0)
-        {
-            for (auto job : que->runnables)
+            // Check for blocked jobs to delete
+            while (que->blocked.size() > 0)
             {
-                delete job;
+                jobPool.Delete(que->blocked.PopFront());
             }
         }
-
-        delete que; // Delete the actual queue
     }
 }
 //--
 /*
-    Read in the file via the path specified
+    Map in the file via the path specified
     And execute the instruction found on each line
 */
 void MLFQSch::RunInstructionFile(const std::string &filePath)
 {
-    ifstream FIN(filePath);
-    if (!FIN.is_open())
+    TraceReader trace;
+    if (!trace.Open(filePath.c_str()))
     {
         fprintf(stderr, "Input file failed to open.\n");
+        out.Flush();
         exit(1);
     }
-    // File opened successfully
-    string line;
-    // Read each line from the file
-    while (getline(FIN, line))
+    // File mapped successfully
+    TraceCommand cmd;
+    // Run each (non-blank) line from the file
+    while (trace.Next(cmd))
     {
-        if (line != "" && line != "\n" && line != "\r")
-        {
-            RunInstructionString(line);
-        }
+        RunCommand(cmd);
     }
-    FIN.close();
 }
 //--
 /*
@@ -78,162 +89,70 @@ void MLFQSch::RunInstructionFile(const std::string &filePath)
     Separate the string into the appropriate details and use it
     to call RunCommand
  */
-void MLFQSch::RunInstructionString(std::string line)
+void MLFQSch::RunInstructionString(std::string_view line)
 {
-    stringstream SIN(line);
-    if (SIN.good())
+    TraceCommand cmd;
+    if (ParseTraceLine(line, cmd))
     {
-        string opcode;
-        string arg1;
-
-        getline(SIN, opcode, ','); // Read the opcode
-        if (line.size() > 0)
-        {
-            if (line.find(',') != string::npos)
-            {
-                // We found a comma
-                getline(SIN, arg1, ',');
-            }
-            else
-            {
-                getline(SIN, arg1);
-            }
-        }
-
-        RunCommand(opcode, arg1);
+        RunCommand(cmd);
     }
 }
 //--
 /*
-    Parses the given opcode and any potential arguments
-Args:
-    const string opcode --> The string representation of an instruction
-
-Return:
-    OPCODE --> The supplied opcode argument transformed into the proper ENUM
-*/
-OPCODE MLFQSch::ParseCode(const string &opcode)
-{
-    // Using the first letter of the opcode,
-    // we can go through a switch statement to determine the proper value
-    switch (opcode.at(0))
-    {
-    case 'n':
-    {
-        if (opcode == "newjob")
-        {
-            return NEWJOB;
-        }
-        break;
-    }
-    case 'e':
-    {
-        if (opcode == "epoch")
-        {
-            return EPOCH;
-        }
-        break;
-    }
-    case 'f':
-    {
-        if (opcode == "finish")
-        {
-            return FINISH;
-        }
-        break;
-    }
-    case 'i':
-    {
-        if (opcode == "interrupt")
-        {
-            return INTERRUPT;
-        }
-        break;
-    }
-    case 'b':
-    {
-        if (opcode == "block")
-        {
-            return BLOCK;
-        }
-        else if (opcode == "blocked")
-        {
-            return BLOCKED;
-        }
-        break;
-    }
-    case 'u':
-    {
-        if (opcode == "unblock")
-        {
-            return UNBLOCK;
-        }
-        break;
-    }
-    case 'r':
-    {
-        if (opcode == "running")
-        {
-            return RUNNING;
-        }
-        else if (opcode == "runnable")
-        {
-            return RUNNABLE;
-        }
-        break;
-    }
-    default:
-    {
-        break;
-    }
-    }
-    fprintf(stderr, "ERROR: Invalid instruction found:%s\n", opcode.c_str());
-    return INVALID;
-}
-//--
-/*
-Given the read in instruction & argument, convert the instruction using ParseCode and run the desired instruction
+Given an instruction already parsed by the trace parser, run the desired instruction
 
 Instruct List
     opcode	    argument 1      meaning
     newjob	    NAME	  	    A new job arrives with the given NAME
-    finish			            The currently running job has terminated - it is an error if the system is idlee
-    interrupt			        A timer interrupt has occurred - the currently running job's quantum is over
-    block			            The currently running job has become blocked
+    finish	    CPU		        The job running on CPU has terminated - it is an error if CPU is idle
+    interrupt	CPU		        A timer interrupt has occurred on CPU - its running job's quantum is over
+    block	    CPU		        The job running on CPU has become blocked
     unblock	    NAME            The named job becomes unblocked - it is an error if it was not blocked
     runnable			        Print information about the jobs in the runnable queue
     running			            Print information about the currently running job
     blocked			            Print information about the jobs on the blocked queue
-    epoch                       An Epoch has elapsed. Process as per MLFQ algorithm
+    epoch                       An Epoch has elapsed. Process as per MLFQ algorithm (on every CPU)
+
+    CPU is optional and counts from 0, which is the CPU used when it is left out (or is not a number)
 */
-void MLFQSch::RunCommand(const string &opcode, const string &arg1 = "")
+void MLFQSch::RunCommand(const TraceCommand &cmd)
 {
-    OPCODE oCode = ParseCode(opcode);
-    switch (oCode)
+    stats.instructions++;
+    uint32_t cpuIndex = 0;
+    switch (cmd.opcode)
     {
     case NEWJOB:
     {
-        CreateNewJob(arg1);
+        CreateNewJob(cmd.arg1);
         break;
     }
     case INTERRUPT:
     {
-        Interrupt();
+        if (FindCpu(cmd.arg1, cpuIndex))
+        {
+            Interrupt(cpuIndex);
+        }
         break;
     }
     case BLOCK:
     {
-        Block();
+        if (FindCpu(cmd.arg1, cpuIndex))
+        {
+            Block(cpuIndex);
+        }
         break;
     }
     case UNBLOCK:
     {
-        UnBlock(arg1);
+        UnBlock(cmd.arg1);
         break;
     }
     case FINISH:
     {
-        FinishJob();
+        if (FindCpu(cmd.arg1, cpuIndex))
+        {
+            FinishJob(cpuIndex);
+        }
         break;
     }
     case RUNNING:
@@ -264,6 +183,29 @@ void MLFQSch::RunCommand(const string &opcode, const string &arg1 = "")
     }
 }
 //--
+/*
+    Read the CPU an opcode is aimed at, CPU 0 when none is given
+    Only an argument that is all digits names a CPU, anything else is a comment (as older traces have)
+    It is an error to name a CPU that is not being simulated
+*/
+bool MLFQSch::FindCpu(string_view text, uint32_t &cpuIndex)
+{
+    cpuIndex = 0;
+    from_chars_result result = from_chars(text.data(), text.data() + text.size(), cpuIndex);
+    if (text.size() == 0 || result.ptr != text.data() + text.size())
+    {
+        cpuIndex = 0;
+        return true;
+    }
+    if (result.ec != errc() || cpuIndex >= cpuCount)
+    {
+        Report("Error. CPU: ", text, " does not exist.\n");
+        stats.errors++;
+        return false;
+    }
+    return true;
+}
+//--
 /*
     You will be told when an epoch has expired when you receive an "epoch" command.
     Handle this as per the MLFQ algorithm.
@@ -277,42 +219,112 @@ void MLFQSch::RunCommand(const string &opcode, const string &arg1 = "")
     Rule 5: After some time period S,
         move all the jobs in the system to the topmost queue.
 
-    Runnables, blocked, running
+    Runnables, blocked, running (one CPU after another)
+
+    Nothing is done job by job: every lower queue's runnables and blocked lists are spliced onto the
+    end of queue 0's, and bumping the generation marks them all as being in queue 0.
+    A job's own priority is only brought up to date the next time it is looked at (LevelOf).
+    Walking the jobs is only needed to print their "lifted up" lines, so it is skipped when not verbose.
 */
 void MLFQSch::HandleEpoch()
 {
-    for (uint32_t queueIndex = 1; queueIndex < allQueues.size(); queueIndex++)
+    stats.epochs++;
+    epochGeneration++;
+    if (recordTransitions)
+    {
+        // Only needed to date boosts for the transition CSV, so a run without one doesn't grow with every epoch
+        epochTicks.push_back(stats.interrupts);
+    }
+    // Every job below queue 0 (on any CPU) is lifted, the counts move with them
+    LevelStats &top = levelStats[0];
+    SettleResidency(top);
+    for (uint32_t levelIndex = 1; levelIndex < levelCount; levelIndex++)
+    {
+        LevelStats &level = levelStats[levelIndex];
+        SettleResidency(level);
+        level.boosts += level.jobs;
+        top.jobs += level.jobs;
+        top.runnable += level.runnable;
+        level.jobs = 0;
+        level.runnable = 0;
+    }
+    for (uint32_t cpuIndex = 0; cpuIndex < cpuCount; cpuIndex++)
     {
-        // ^^ Skipping the first queue, go through the rest
-        FeedbackQueue *fbq = allQueues.at(queueIndex);
-        // vv The queue we are looking at has some runnables to move up
-        if (fbq->runnables.size() > 0)
+        Cpu &cpu = cpus[cpuIndex];
+        FeedbackQueue *topQueue = &cpu.allQueues[0];
+        for (uint32_t queueIndex = 1; queueIndex < levelCount; queueIndex++)
         {
-            while (fbq->runnables.size() > 0)
+            // ^^ Skipping the first queue, go through the rest
+            FeedbackQueue *fbq = &cpu.allQueues[queueIndex];
+            if (verbose)
             {
-                fbq->runnables.front()->priority = 0;                         // Mark the priority as 0
-                allQueues.at(0)->runnables.push_back(fbq->runnables.front()); // Take the front job and move it to the top FBQ
-                printf("Job: %s lifted up.\n", fbq->runnables.front()->name.c_str());
-                fbq->runnables.pop_front(); // Remove it from the runnables
+                for (Job *job : fbq->runnables)
+                {
+                    ReportOn(cpuIndex, "Job: ", job->name, " lifted up.\n");
+                }
+                for (Job *job : fbq->blocked)
+                {
+                    ReportOn(cpuIndex, "Job: ", job->name, " lifted up.\n");
+                }
             }
+            // Move them to the top FBQ, keeping their order
+            topQueue->runnables.SpliceBack(fbq->runnables);
+            topQueue->blocked.SpliceBack(fbq->blocked);
         }
-        // The queue we are looking at has some blocked jobs to move
-        if (fbq->blocked.size() > 0)
+        cpu.nonEmptyQueues = (topQueue->runnables.size() > 0) ? 1 : 0;
+        if (cpu.currRunningJob)
         {
-            while (fbq->blocked.size() > 0)
-            {
-                fbq->blocked.front()->priority = 0;                       // Mark the priority as 0
-                allQueues.at(0)->blocked.push_back(fbq->blocked.front()); // Take the front job and move it to the top FBQ
-                printf("Job: %s lifted up.\n", fbq->blocked.front()->name.c_str());
-                fbq->blocked.pop_front(); // Remove it from the runnables
-            }
+            LevelOf(cpu.currRunningJob);
+            ReportOn(cpuIndex, "Job: ", cpu.currRunningJob->name, " lifted up.\n");
+        }
+    }
+}
+//--
+/*
+    The queue a job is in
+    An epoch since its priority was last set means it has been lifted up to queue 0,
+    with all of queue 0's allotment ahead of it
+*/
+uint32_t MLFQSch::LevelOf(Job *job)
+{
+    if (job->generation != epochGeneration)
+    {
+        if (recordTransitions && job->priority > 0)
+        {
+            // Lifted by the first epoch after it was last placed
+            RecordTransition(job, epochTicks[job->generation], int32_t(job->priority), 0);
         }
+        job->priority = 0;
+        job->used = 0;
+        job->slice = 0;
+        job->generation = epochGeneration;
+    }
+    return job->priority;
+}
+//--
+/*
+    Add a job to the runnables of its queue on its CPU
+*/
+void MLFQSch::MakeRunnable(Job *job, const bool &atFront)
+{
+    Cpu &cpu = cpus[job->cpu];
+    FeedbackQueue *queue = &cpu.allQueues[job->priority];
+    if (atFront)
+    {
+        queue->runnables.PushFront(job);
     }
-    if (currRunningJob)
+    else
     {
-        currRunningJob->priority = 0;
-        printf("Job: %s lifted up.\n", currRunningJob->name.c_str());
+        queue->runnables.PushBack(job);
     }
+    cpu.nonEmptyQueues |= uint64_t(1) << job->priority;
+    cpu.runnableCount++;
+
+    LevelStats &level = levelStats[job->priority];
+    level.enqueues++;
+    level.runnable++;
+    level.depthTotal += level.runnable;
+    level.depthMax = (level.runnable > level.depthMax) ? level.runnable : level.depthMax;
 }
 //--
 /*
@@ -323,22 +335,41 @@ void MLFQSch::HandleEpoch()
     Its name and priority are given.
     Assume all job names are unique.
     A new job's arrival does not cause a rescheduling unless the system was idle.
+
+    It joins the CPU with the fewest jobs (running or runnable), the first of them on a tie.
 */
-void MLFQSch::CreateNewJob(const string &name)
+void MLFQSch::CreateNewJob(string_view name)
 {
-    FeedbackQueue *highestQueue = allQueues.at(0);
+    uint32_t target = 0;
+    size_t targetLoad = SIZE_MAX;
+    for (uint32_t cpuIndex = 0; cpuIndex < cpuCount; cpuIndex++)
+    {
+        size_t load = cpus[cpuIndex].runnableCount + ((cpus[cpuIndex].currRunningJob != nullptr) ? 1 : 0);
+        if (load < targetLoad)
+        {
+            target = cpuIndex;
+            targetLoad = load;
+        }
+    }
 
-    // Create Job on heap
-    // Job(std::string n, uint32_t p) { name = n;  priority = p; }
-    Job *nJob = new Job(name, 0);
-    highestQueue->runnables.push_back(nJob);
+    // Create Job in the pool
+    Job *nJob = jobPool.New(name, stats.newJobs, 0, epochGeneration, target, stats.interrupts);
+    if (recordTransitions)
+    {
+        jobNames.emplace_back(name);
+        RecordTransition(nJob, stats.interrupts, -1, 0);
+    }
+    JoinLevel(0);
+    MakeRunnable(nJob, false);
+    jobIndex[nJob->name] = nJob;
+    stats.newJobs++;
 
-    printf("New job: %s added.\n", name.c_str());
+    ReportOn(target, "New job: ", nJob->name, " added.\n");
 
-    if (systemRunning == false)
+    if (cpus[target].currRunningJob == nullptr)
     {
         // System not running previously
-        ScheduleNextJob();
+        ScheduleNextJob(target);
     }
 }
 //--
@@ -347,63 +378,155 @@ void MLFQSch::CreateNewJob(const string &name)
     MEANING:    The currently running job has completed and should be removed from the system.
                 If the system is idle, it is an error.
 */
-void MLFQSch::FinishJob()
+void MLFQSch::FinishJob(const uint32_t &cpuIndex)
 {
-    if (systemRunning)
+    Cpu &cpu = cpus[cpuIndex];
+    if (cpu.currRunningJob != nullptr)
     {
-        printf("Job: %s completed.\n", currRunningJob->name.c_str());
-        delete currRunningJob;
-        currRunningJob = nullptr;
-        ScheduleNextJob();
+        Job *job = cpu.currRunningJob;
+        ReportOn(cpuIndex, "Job: ", job->name, " completed.\n");
+        stats.completed++;
+        latencies.turnaround.Record(stats.interrupts - job->arrival);
+        latencies.longestWait.Record(job->longestWait);
+        uint32_t level = LevelOf(job);
+        LeaveLevel(level);
+        if (recordTransitions)
+        {
+            RecordTransition(job, stats.interrupts, int32_t(level), -1);
+        }
+        jobIndex.erase(cpu.currRunningJob->name);
+        jobPool.Delete(cpu.currRunningJob);
+        cpu.currRunningJob = nullptr;
+        ScheduleNextJob(cpuIndex);
     }
     else
     {
-        printf("Error. System is idle.\n");
+        ReportOn(cpuIndex, "Error. System is idle.\n");
+        stats.errors++;
     }
 }
 //--
 /*
     Use the MLFQ scheduling algorithm
 
+    The highest queue with something to run is the lowest set bit of nonEmptyQueues,
+    found with one count-trailing-zeros however many queues there are.
+    A CPU with nothing of its own to run steals from the CPU with the most runnables,
+    taking the job its highest non-empty queue would run next.
 */
-void MLFQSch::ScheduleNextJob()
+void MLFQSch::ScheduleNextJob(const uint32_t &cpuIndex)
 {
-
-    u_int16_t hqI = 0;
-    FeedbackQueue *highestQueue = allQueues.at(hqI);
-    bool somethingToRun = false;
-
-    for (hqI = 0; hqI < allQueues.size(); hqI++)
+    Cpu &cpu = cpus[cpuIndex];
+    uint32_t from = (cpu.nonEmptyQueues != 0) ? cpuIndex : BusiestCpu();
+    Cpu &source = cpus[from];
+    if (source.nonEmptyQueues != 0)
     {
-        // For each of our queues
-        // If the one we are looking at has something to run
-        // Let's keep track of it
-        if (allQueues.at(hqI)->runnables.size() > 0)
+        uint32_t hqI = uint32_t(__builtin_ctzll(source.nonEmptyQueues));
+        FeedbackQueue *highestQueue = &source.allQueues[hqI];
+
+        // Find the next highest job in the highest queue and run it
+        Job *job = highestQueue->runnables.PopFront();
+        source.runnableCount--;
+        levelStats[hqI].runnable--;
+        if (highestQueue->runnables.size() == 0)
         {
-            somethingToRun = true;
-            highestQueue = allQueues.at(hqI);
-            break;
+            source.nonEmptyQueues &= ~(uint64_t(1) << hqI);
         }
-    }
-
-    if (somethingToRun)
-    {
-        // Now we have some runnable at our current highestQueue
-        if (!systemRunning)
+        LevelOf(job);   // Bring its priority up to date with the queue it came from
+        job->slice = 0; // And start it on a fresh quantum
+        job->cpu = cpuIndex;
+        StartRunning(job);
+        cpu.currRunningJob = job;
+        if (from != cpuIndex)
         {
-            systemRunning = true;
+            stats.steals++;
+            ReportOn(cpuIndex, "Job: ", job->name, " stolen from CPU ", from, ".\n");
         }
-
-        // Find the next highest job in the highest queue and run it
-        currRunningJob = highestQueue->runnables.front();
-        highestQueue->runnables.pop_front();
-        printf("Job: %s scheduled.\n", currRunningJob->name.c_str());
+        stats.schedules++;
+        ReportOn(cpuIndex, "Job: ", job->name, " scheduled.\n");
     }
     else
     {
         // We have nothing to run, thus we become idle
-        systemRunning = false;
-        printf("System is idle.\n");
+        cpu.currRunningJob = nullptr;
+        stats.idles++;
+        ReportOn(cpuIndex, "System is idle.\n");
+    }
+}
+//--
+/*
+    A job is about to run: the time since it became runnable is over, and if it is its first run, so is its response time
+*/
+void MLFQSch::StartRunning(Job *job)
+{
+    uint64_t wait = stats.interrupts - job->readySince;
+    job->longestWait = (wait > job->longestWait) ? wait : job->longestWait;
+    if (!job->started)
+    {
+        job->started = true;
+        latencies.response.Record(stats.interrupts - job->arrival);
+    }
+}
+//--
+/*
+    A job arrives at or leaves a level
+    The ticks every job spent at the level so far are added up first, so each change costs the same however many jobs there are
+*/
+void MLFQSch::JoinLevel(const uint32_t &level)
+{
+    SettleResidency(levelStats[level]);
+    levelStats[level].jobs++;
+}
+//--
+void MLFQSch::LeaveLevel(const uint32_t &level)
+{
+    SettleResidency(levelStats[level]);
+    levelStats[level].jobs--;
+}
+//--
+void MLFQSch::SettleResidency(LevelStats &level)
+{
+    level.residentTicks += level.jobs * (stats.interrupts - level.lastChange);
+    level.lastChange = stats.interrupts;
+}
+//--
+void MLFQSch::RecordTransition(const Job *job, const uint64_t &tick, const int32_t &from, const int32_t &to)
+{
+    transitions.push_back(Transition{tick, job->id, from, to});
+}
+//--
+/*
+    The CPU with the most runnables, the first of them on a tie
+*/
+uint32_t MLFQSch::BusiestCpu() const
+{
+    uint32_t busiest = 0;
+    for (uint32_t cpuIndex = 1; cpuIndex < cpuCount; cpuIndex++)
+    {
+        if (cpus[cpuIndex].runnableCount > cpus[busiest].runnableCount)
+        {
+            busiest = cpuIndex;
+        }
+    }
+    return busiest;
+}
+//--
+/*
+    A job left runnable on a busy CPU while another sits idle is stolen straight away,
+    so no CPU stays idle while there is anything to run
+*/
+void MLFQSch::WakeIdleCpus()
+{
+    for (uint32_t cpuIndex = 0; cpuIndex < cpuCount && cpuCount > 1; cpuIndex++)
+    {
+        if (cpus[cpuIndex].currRunningJob == nullptr)
+        {
+            if (cpus[BusiestCpu()].runnableCount == 0)
+            {
+                return;
+            }
+            ScheduleNextJob(cpuIndex);
+        }
     }
 }
 /*
@@ -416,35 +539,57 @@ void MLFQSch::ScheduleNextJob()
     Rule 4: Once a job uses up its time allotment at a
     given level (regardless of how many times it has given up the CPU), its priority is
     reduced (i.e., it moves down one queue)
+
+    Each interrupt is one tick of the running job's quantum and of its allotment at its level.
+    Until its quantum is over it keeps running (and the scheduler does not run).
+    Once it is over, it goes to the back of its queue, or of the next one down if its allotment is used up too.
+    The allotment used is kept while a job is blocked, so giving up the CPU early does not keep a job up high.
 */
-void MLFQSch::Interrupt()
+void MLFQSch::Interrupt(const uint32_t &cpuIndex)
 {
-    if (systemRunning)
+    Cpu &cpu = cpus[cpuIndex];
+    if (cpu.currRunningJob != nullptr)
     {
-        if (currRunningJob != nullptr)
+        stats.interrupts++;
+        Job *job = cpu.currRunningJob;
+        FeedbackQueue *queue = &cpu.allQueues[job->priority];
+        job->used++;
+        job->slice++;
+        levelStats[job->priority].ranTicks++;
+        if (job->used >= queue->allotment && job->priority < levelCount - 1)
         {
-            // Add our currently running job back into the runnables queue
+            // Its allotment is used up, add it to the runnables
             // OF THE NEXT LOWEST QUEUE
-            if (currRunningJob->priority < allQueues.size() - 1)
+            levelStats[job->priority].demotions++;
+            LeaveLevel(job->priority);
+            JoinLevel(job->priority + 1);
+            if (recordTransitions)
             {
-                // WE are at the second to last (or higher) queue
-                currRunningJob->priority++;
-                allQueues.at(currRunningJob->priority)->runnables.push_back(currRunningJob);
-                currRunningJob = nullptr;
-            }
-            else
-            {
-                // WE are at the highest queue
-                allQueues.at(currRunningJob->priority)->runnables.push_back(currRunningJob);
-                currRunningJob = nullptr;
+                RecordTransition(job, stats.interrupts, int32_t(job->priority), int32_t(job->priority + 1));
             }
+            job->priority++;
+            job->used = 0;
+            job->readySince = stats.interrupts;
+            MakeRunnable(job, false);
+            cpu.currRunningJob = nullptr;
+        }
+        else if (job->slice >= queue->quantum)
+        {
+            // Its quantum is over (or it is in the lowest queue), back of its own queue
+            job->readySince = stats.interrupts;
+            MakeRunnable(job, false);
+            cpu.currRunningJob = nullptr;
+        }
+        if (cpu.currRunningJob == nullptr)
+        {
+            ScheduleNextJob(cpuIndex); // Run the next job
         }
-        ScheduleNextJob(); // Run the next job
     }
     else
     {
         // System is IDLE
-        printf("Error. System is idle.\n");
+        ReportOn(cpuIndex, "Error. System is idle.\n");
+        stats.errors++;
     }
 }
 //--
@@ -453,20 +598,24 @@ void MLFQSch::Interrupt()
     MEANING: The currently running task has become blocked. Perhaps it is asking for an I/O.
     It is an error if the system is idle.
 */
-void MLFQSch::Block()
+void MLFQSch::Block(const uint32_t &cpuIndex)
 {
-    if (systemRunning)
+    Cpu &cpu = cpus[cpuIndex];
+    if (cpu.currRunningJob != nullptr)
     {
-        Job *bljb = currRunningJob;
-        allQueues.at(bljb->priority)->blocked.push_back(bljb); // Add the job to the blocked in the queue
-        printf("Job: %s blocked.\n", bljb->name.c_str());
-        currRunningJob = nullptr;
-        ScheduleNextJob();
+        Job *bljb = cpu.currRunningJob;
+        bljb->blocked = true;
+        cpu.allQueues[LevelOf(bljb)].blocked.PushBack(bljb); // Add the job to the blocked in the queue
+        stats.blocks++;
+        ReportOn(cpuIndex, "Job: ", bljb->name, " blocked.\n");
+        cpu.currRunningJob = nullptr;
+        ScheduleNextJob(cpuIndex);
     }
     else
     {
         // System is IDLE
-        printf("Error. System is idle.\n");
+        ReportOn(cpuIndex, "Error. System is idle.\n");
+        stats.errors++;
     }
 }
 //--
@@ -476,58 +625,68 @@ void MLFQSch::Block()
     MEANING: The named job has become unblocked.
 
     It is an error if the named job was not blocked.
-    Unblocked jobs return to the runnables. The scheduler is not run unless the system was idle.
+    Unblocked jobs return to the front of their queue's runnables. The scheduler is not run unless the system was idle,
+    or the unblocked job is in a higher queue than the running job, which it then preempts.
+    Both are about the CPU the job blocked on.
+
+    The job is found through the name index and unlinked from its queue's blocked list directly,
+    so this costs the same however many jobs are blocked.
 */
-void MLFQSch::UnBlock(const string &name)
+void MLFQSch::UnBlock(string_view name)
 {
-    bool jobWasUnBlocked = false;
-    Job *jobToUnBlock = nullptr;
-
-    for (FeedbackQueue *queue : allQueues)
-    {
-        // Go through each of our queues
-        for (size_t i = 0; i < queue->blocked.size(); i++)
-        {
-            // Go through each of the blocked jobs in the queue's blocked vector
-            if (queue->blocked.at(i)->name == name)
-            {
-                // This job is the one we want to unblock
-                jobWasUnBlocked = true;
-                jobToUnBlock = queue->blocked.at(i);
-
-                queue->runnables.push_front(jobToUnBlock);
-                queue->blocked.erase(queue->blocked.begin() + i); // Erase the blocked job from the blocked jobs vector
-                break;
-            }
-        }
-        if (jobWasUnBlocked)
-        {
-            break;
-        }
-    }
+    unordered_map<string_view, Job*>::iterator found = jobIndex.find(name);
+    bool jobWasUnBlocked = found != jobIndex.end() && found->second->blocked;
+    Job *jobToUnBlock = jobWasUnBlocked ? found->second : nullptr;
 
     if (jobWasUnBlocked)
     {
-        printf("Job: %s has unblocked.\n", jobToUnBlock->name.c_str());
-        if(currRunningJob != nullptr)
+        Cpu &cpu = cpus[jobToUnBlock->cpu];
+        cpu.allQueues[LevelOf(jobToUnBlock)].blocked.Remove(jobToUnBlock);
+        jobToUnBlock->blocked = false;
+        jobToUnBlock->readySince = stats.interrupts;
+        MakeRunnable(jobToUnBlock, true);
+
+        stats.unblocks++;
+        ReportOn(jobToUnBlock->cpu, "Job: ", jobToUnBlock->name, " has unblocked.\n");
+        if(cpu.currRunningJob != nullptr)
         {
-            if(jobToUnBlock->priority < currRunningJob->priority)
+            if(jobToUnBlock->priority < LevelOf(cpu.currRunningJob))
             {
                 // Our jobtounblock has a BETTER priority and needs to be the one running
                 // Add our currently running job back to it's original queue
-                allQueues.at(currRunningJob->priority)->runnables.push_back(currRunningJob);
-                currRunningJob = nullptr;
+                cpu.currRunningJob->readySince = stats.interrupts;
+                MakeRunnable(cpu.currRunningJob, false);
+                cpu.currRunningJob = nullptr;
             }
         }
-        ScheduleNextJob();
+        if (cpu.currRunningJob == nullptr)
+        {
+            // Idle, or the running job was just preempted
+            ScheduleNextJob(jobToUnBlock->cpu);
+        }
+        WakeIdleCpus();
     }
     else
     {
         // Job was not previously blocked!
-        printf("Error. Job: %s not blocked.\n", name.c_str());
+        Report("Error. Job: ", name, " not blocked.\n");
+        stats.errors++;
     }
 }
 //--
+/*
+    One row of a listing, with the CPU the job is on when there is more than one
+*/
+void MLFQSch::PrintJob(Job *job)
+{
+    Report(Column(job->name, 8), Column(LevelOf(job), 8));
+    if (cpuCount > 1)
+    {
+        Report(Column(job->cpu, 8));
+    }
+    Report('\n');
+}
+//--
 /*
     OPCODE: runnable
     MEANING: The runnables, if any, are listed.
@@ -541,27 +700,36 @@ void MLFQSch::UnBlock(const string &name)
         G       3
         T       3
     These must be listed in the order they would be scheduled.
+    With more than one CPU, each CPU's runnables are listed in turn.
 */
 void MLFQSch::PrintRunnables()
 {
-    printf("Runnables:\n");
+    if (!verbose)
+    {
+        return; // Nothing would be printed, don't walk the lists for it
+    }
+    Report("Runnables:\n");
     bool headingPrinted = false;
-    for (auto queue : allQueues)
+    for (uint32_t cpuIndex = 0; cpuIndex < cpuCount; cpuIndex++)
     {
-        // For each of our queues
-        // GO through each job if they have any
-        // And print out the info
-        if (queue->runnables.size() > 0)
+        for (uint32_t queueIndex = 0; queueIndex < levelCount; queueIndex++)
         {
-            if (headingPrinted == false)
+            FeedbackQueue *queue = &cpus[cpuIndex].allQueues[queueIndex];
+            // For each of our queues
+            // GO through each job if they have any
+            // And print out the info
+            if (queue->runnables.size() > 0)
             {
-                printf("NAME    QUEUE   \n");
-                headingPrinted = true;
-            }
-            // We have items in our runnables in the indexed queue to print out
-            for (Job *idleJob : queue->runnables)
-            {
-                printf("%-8s%-8u\n", idleJob->name.c_str(), idleJob->priority);
+                if (headingPrinted == false)
+                {
+                    Report((cpuCount > 1) ? "NAME    QUEUE   CPU     \n" : "NAME    QUEUE   \n");
+                    headingPrinted = true;
+                }
+                // We have items in our runnables in the indexed queue to print out
+                for (Job *idleJob : queue->runnables)
+                {
+                    PrintJob(idleJob);
+                }
             }
         }
     }
@@ -569,7 +737,7 @@ void MLFQSch::PrintRunnables()
     if (!headingPrinted)
     {
         // Heading wasn't printed thus we had nothing to print out
-        printf("None\n");
+        Report("None\n");
     }
 }
 //--
@@ -580,18 +748,32 @@ void MLFQSch::PrintRunnables()
             Running:
             NAME    QUEUE
             H       0
+    With more than one CPU, every CPU's running job is listed.
 */
 void MLFQSch::PrintRunningTask()
 {
-    printf("Running:\n");
-    if (currRunningJob != nullptr)
+    if (!verbose)
     {
-        printf("NAME    QUEUE   \n");
-        printf("%-8s%-8u\n", currRunningJob->name.c_str(), currRunningJob->priority);
+        return; // Nothing would be printed, don't walk the lists for it
     }
-    else
+    Report("Running:\n");
+    bool headingPrinted = false;
+    for (uint32_t cpuIndex = 0; cpuIndex < cpuCount; cpuIndex++)
+    {
+        if (cpus[cpuIndex].currRunningJob != nullptr)
+        {
+            if (headingPrinted == false)
+            {
+                Report((cpuCount > 1) ? "NAME    QUEUE   CPU     \n" : "NAME    QUEUE   \n");
+                headingPrinted = true;
+            }
+            PrintJob(cpus[cpuIndex].currRunningJob);
+        }
+    }
+
+    if (!headingPrinted)
     {
-        printf("None\n");
+        Report("None\n");
     }
 }
 //--
@@ -608,24 +790,32 @@ void MLFQSch::PrintRunningTask()
 */
 void MLFQSch::PrintBlockedTasks()
 {
-    printf("Blocked:\n");
+    if (!verbose)
+    {
+        return; // Nothing would be printed, don't walk the lists for it
+    }
+    Report("Blocked:\n");
     bool headingPrinted = false;
-    for (auto queue : allQueues)
+    for (uint32_t cpuIndex = 0; cpuIndex < cpuCount; cpuIndex++)
     {
-        // For each of our queues
-        // GO through each job if they have any
-        // And print out the info
-        if (queue->blocked.size() > 0)
+        for (uint32_t queueIndex = 0; queueIndex < levelCount; queueIndex++)
         {
-            if (headingPrinted == false)
-            {
-                printf("NAME    QUEUE   \n");
-                headingPrinted = true;
-            }
-            // We have items in our runnables in the indexed queue to print out
-            for (Job *idleJob : queue->blocked)
+            FeedbackQueue *queue = &cpus[cpuIndex].allQueues[queueIndex];
+            // For each of our queues
+            // GO through each job if they have any
+            // And print out the info
+            if (queue->blocked.size() > 0)
             {
-                printf("%-8s%-8u\n", idleJob->name.c_str(), idleJob->priority);
+                if (headingPrinted == false)
+                {
+                    Report((cpuCount > 1) ? "NAME    QUEUE   CPU     \n" : "NAME    QUEUE   \n");
+                    headingPrinted = true;
+                }
+                // We have items in our runnables in the indexed queue to print out
+                for (Job *idleJob : queue->blocked)
+                {
+                    PrintJob(idleJob);
+                }
             }
         }
     }
@@ -633,7 +823,218 @@ void MLFQSch::PrintBlockedTasks()
     if (!headingPrinted)
     {
         // Heading wasn't printed thus we had nothing to print out
-        printf("None\n");
+        Report("None\n");
+    }
+}
+//--
+/*
+    Turn the per event output on or off
+    When off, only the summary statistics are worth printing
+*/
+void MLFQSch::SetVerbose(const bool& on)
+{
+    verbose = on;
+}
+//--
+/*
+    Push out whatever output is still buffered
+*/
+void MLFQSch::FlushOutput()
+{
+    out.Flush();
+}
+//--
+/*
+    The name of the job running on a CPU, empty when it is idle
+    Lets a driver (i.e. the JobSimulator) decide what that job does next
+*/
+string_view MLFQSch::RunningJobName(const uint32_t& cpuIndex) const
+{
+    const Job *job = cpus[cpuIndex].currRunningJob;
+    return (job != nullptr) ? string_view(job->name) : string_view();
+}
+//--
+/*
+    The longest any job still runnable has been waiting to run, in ticks
+    Jobs a run ends on never reach Latencies(), and the one starved the longest is likely among them
+*/
+uint64_t MLFQSch::LongestCurrentWait() const
+{
+    uint64_t longest = 0;
+    for (uint32_t cpuIndex = 0; cpuIndex < cpuCount; cpuIndex++)
+    {
+        for (uint32_t queueIndex = 0; queueIndex < levelCount; queueIndex++)
+        {
+            for (const Job *job : cpus[cpuIndex].allQueues[queueIndex].runnables)
+            {
+                uint64_t wait = stats.interrupts - job->readySince;
+                longest = (wait > longest) ? wait : longest;
+            }
+        }
+    }
+    return longest;
+}
+//--
+/*
+    Keep a record of every job's level changes for WriteTransitionCsv
+    Turned on before the first instruction, it holds one entry per change (and each job's name) for the whole run
+*/
+void MLFQSch::RecordTransitions(const bool& on)
+{
+    recordTransitions = on;
+}
+//--
+/*
+    A path of "-" is standard output, after whatever the scheduler has printed so far
+*/
+FILE* MLFQSch::OpenCsv(const string& filePath)
+{
+    if (filePath == "-")
+    {
+        out.Flush();
+        return stdout;
+    }
+    return fopen(filePath.c_str(), "w");
+}
+//--
+bool MLFQSch::CloseCsv(FILE* fout)
+{
+    return (fout == stdout) ? fflush(fout) == 0 : fclose(fout) == 0;
+}
+//--
+/*
+    A name straight from the trace, quoted only if it holds a comma, quote or line break, with its quotes doubled (RFC 4180)
+*/
+void MLFQSch::WriteCsvField(FILE* fout, string_view text)
+{
+    if (text.find_first_of(",\"\r\n") == string_view::npos)
+    {
+        fwrite(text.data(), 1, text.size(), fout);
+        return;
+    }
+    fputc('"', fout);
+    for (char c : text)
+    {
+        if (c == '"')
+        {
+            fputc('"', fout);
+        }
+        fputc(c, fout);
+    }
+    fputc('"', fout);
+}
+//--
+/*
+    Write the per level counters as CSV, one row per level
+    residentTicks is brought up to date first, so it covers the whole run
+*/
+bool MLFQSch::WriteLevelCsv(const string& filePath)
+{
+    FILE* fout = OpenCsv(filePath);
+    if (fout == nullptr)
+    {
+        return false;
+    }
+    fprintf(fout, "level,quantum,allotment,enqueues,demotions,boosts,ran_ticks,resident_ticks,mean_depth,max_depth,jobs_at_end\n");
+    for (uint32_t levelIndex = 0; levelIndex < levelCount; levelIndex++)
+    {
+        LevelStats &level = levelStats[levelIndex];
+        SettleResidency(level);
+        double meanDepth = (level.enqueues > 0) ? double(level.depthTotal) / double(level.enqueues) : 0;
+        fprintf(fout, "%u,%u,%u,%llu,%llu,%llu,%llu,%llu,%.3f,%llu,%llu\n", levelIndex,
+                cpus[0].allQueues[levelIndex].quantum, cpus[0].allQueues[levelIndex].allotment,
+                (unsigned long long)level.enqueues, (unsigned long long)level.demotions, (unsigned long long)level.boosts,
+                (unsigned long long)level.ranTicks, (unsigned long long)level.residentTicks, meanDepth,
+                (unsigned long long)level.depthMax, (unsigned long long)level.jobs);
+    }
+    return CloseCsv(fout);
+}
+//--
+/*
+    Write every level change recorded as CSV, in tick order
+    Boosts still waiting to be noticed by jobs that were not looked at again are picked up first
+    from is empty for a new job and to for a finished one
+*/
+bool MLFQSch::WriteTransitionCsv(const string& filePath)
+{
+    FILE* fout = OpenCsv(filePath);
+    if (fout == nullptr)
+    {
+        return false;
+    }
+    for (const pair<const string_view, Job*>& entry : jobIndex)
+    {
+        LevelOf(entry.second);
+    }
+    stable_sort(transitions.begin(), transitions.end(),
+                [](const Transition& a, const Transition& b){ return a.tick < b.tick; });
+    fprintf(fout, "tick,job,from,to\n");
+    for (const Transition& change : transitions)
+    {
+        fprintf(fout, "%llu,", (unsigned long long)change.tick);
+        if (change.job < jobNames.size())
+        {
+            WriteCsvField(fout, jobNames[change.job]);
+        }
+        fputc(',', fout);
+        if (change.from >= 0)
+        {
+            fprintf(fout, "%d", change.from);
+        }
+        fputc(',', fout);
+        if (change.to >= 0)
+        {
+            fprintf(fout, "%d", change.to);
+        }
+        fputc('\n', fout);
+    }
+    return CloseCsv(fout);
+}
+//--
+/*
+    Print the response, turnaround & longest wait percentiles of the jobs that finished
+*/
+void MLFQSch::PrintLatency()
+{
+    WriteLatencies(out, latencies);
+}
+//--
+/*
+    Print the aggregate statistics gathered over the whole run
+    along with what was left in the system at the end
+*/
+void MLFQSch::PrintSummary()
+{
+    size_t runnable = 0;
+    size_t running = 0;
+    size_t blocked = 0;
+    for (uint32_t cpuIndex = 0; cpuIndex < cpuCount; cpuIndex++)
+    {
+        runnable += cpus[cpuIndex].runnableCount;
+        running += (cpus[cpuIndex].currRunningJob != nullptr) ? 1 : 0;
+        for (uint32_t queueIndex = 0; queueIndex < levelCount; queueIndex++)
+        {
+            blocked += cpus[cpuIndex].allQueues[queueIndex].blocked.size();
+        }
+    }
+    stats.Print(out, runnable, running, blocked);
+    out.Flush();
+}
+//--
+bool ReadCountList(const char* text, vector<uint32_t>& values, const unsigned long& minimum)
+{
+    values.clear();
+    while (*text != '\0')
+    {
+        char* end;
+        unsigned long value = strtoul(text, &end, 10);
+        if (end == text || value < minimum || value > UINT32_MAX || (*end != ',' && *end != '\0'))
+        {
+            return false;
+        }
+        values.push_back(uint32_t(value));
+        text = (*end == ',') ? end + 1 : end;
     }
+    return values.size() > 0;
 }
 //--
@@ -1,55 +1,204 @@
 #pragma once
 #include <stdio.h>
 #include <string>
-#include <fstream>
-#include <deque>
+#include <string_view>
+#include <memory>
 #include <vector>
-#include <sstream>
+#include <unordered_map>
+#include "TraceParser.hpp"
+#include "IntrusiveList.hpp"
+#include "ObjectPool.hpp"
+#include "InlineName.hpp"
+#include "OutputSink.hpp"
+#include "JobLatencies.hpp"
+#include "SchedulerStats.hpp"
 
-#define NUMBER_OF_QUEUES 4
+#define DEFAULT_NUMBER_OF_QUEUES 4
+#define MAX_NUMBER_OF_QUEUES 64
+#define MAX_NUMBER_OF_CPUS 1024
 
-enum OPCODE {INVALID, NEWJOB, FINISH, INTERRUPT, BLOCK, UNBLOCK, RUNNABLE, RUNNING, BLOCKED, EPOCH};
+/*
+    The shape of the feedback queues, fixed for the life of a scheduler
+    quanta[i] is how many interrupts a job in queue i runs for before the next job gets a turn,
+    allotments[i] how many it may use in queue i in total (however often it blocks) before it moves down a queue.
+    A level without an entry of its own repeats the last one given, or 1 when none were.
+    Every CPU gets its own set of queues of this shape.
+*/
+struct MLFQConfig
+{
+    uint32_t levels = DEFAULT_NUMBER_OF_QUEUES;
+    std::vector<uint32_t> quanta;
+    std::vector<uint32_t> allotments;
+    uint32_t cpus = 1;
+};
+
+/*
+    Read a comma separated list of counts, i.e. "1,2,4,8", none of them below minimum
+    Shared by the options of the simulator (-t, -a) and of the tuner (every list it sweeps)
+*/
+bool ReadCountList(const char* text, std::vector<uint32_t>& values, const unsigned long& minimum = 1);
 
 class MLFQSch{
 public:
-    MLFQSch();
+    MLFQSch(const MLFQConfig& config = MLFQConfig());
     ~MLFQSch();
     void RunInstructionFile(const std::string& filePath);
-    void RunInstructionString(std::string line);
-    void RunCommand(const std::string& com, const std::string& arg1);
+    void RunInstructionString(std::string_view line);
+    void RunCommand(const TraceCommand& cmd);
+    void SetVerbose(const bool& on);
+    void PrintSummary();
+    void PrintLatency();
+    void FlushOutput();
+    std::string_view RunningJobName(const uint32_t& cpuIndex = 0) const;
+    uint32_t CpuCount() const { return cpuCount; }
+    size_t JobCount() const { return jobIndex.size(); }
+    uint64_t Ticks() const { return stats.interrupts; } // Interrupts taken, on any CPU
+    const JobLatencies& Latencies() const { return latencies; }
+    uint64_t LongestCurrentWait() const;
+    void RecordTransitions(const bool& on);
+    bool WriteLevelCsv(const std::string& filePath);
+    bool WriteTransitionCsv(const std::string& filePath);
 private:
     struct Job
     {
-        Job(const std::string& n, const uint32_t& p) : name(n), priority(p) {}
+        Job(std::string_view n, const uint64_t& i, const uint32_t& p, const uint64_t& g, const uint32_t& c, const uint64_t& now) :
+            name(n), id(i), priority(p), generation(g), used(0), slice(0), cpu(c), blocked(false), started(false),
+            arrival(now), readySince(now), longestWait(0) {}
 
-        std::string name;
-        uint32_t priority; // Represents the queue number they are in
+        InlineName name;     // No allocation for short names
+        uint64_t id;         // Order of arrival, from 0
+        uint32_t priority;   // Represents the queue number they are in, only current while generation is
+        uint64_t generation; // The epoch generation priority, used & slice were last set in
+        uint64_t used;       // Interrupts used of its allotment in this queue, kept while it is blocked
+        uint32_t slice;      // Interrupts used of its current quantum
+        uint32_t cpu;        // The CPU whose queues it is on (or that it is running on)
+        bool blocked;        // On its queue's blocked list
+        bool started;        // Has run at least once
+        uint64_t arrival;    // Tick it arrived on
+        uint64_t readySince; // Tick it last became runnable (arrived, unblocked or was put back on a queue)
+        uint64_t longestWait; // Longest it has sat runnable before running
+        ListLinks<Job> queueLinks; // A job is on at most one list (runnables or blocked) at a time
     };
 
+    /*
+        Jobs are linked straight into the lists, so moving one between lists (or a whole list onto another)
+        allocates nothing
+    */
     struct FeedbackQueue
     {
-        std::deque<Job*> runnables;
-        std::deque<Job*> blocked;
+        IntrusiveList<Job, &Job::queueLinks> runnables;
+        IntrusiveList<Job, &Job::queueLinks> blocked; // In the order they blocked
+        uint32_t quantum = 1;
+        uint32_t allotment = 1;
+    };
+
+    /*
+        One simulated CPU: its own feedback queues and the job running on it
+    */
+    struct Cpu
+    {
+        std::unique_ptr<FeedbackQueue[]> allQueues; // Highest priority first
+        uint64_t nonEmptyQueues = 0;    // Bit i is set while queue i has runnables
+        size_t runnableCount = 0;       // Runnables across all of its queues
+        Job* currRunningJob = nullptr;
     };
 
+    /*
+        What happened at one level, summed over every CPU
+        jobs & runnable are live counts, kept in step as jobs move so that none of them needs a walk of the queues:
+        residentTicks only has to be brought up to date when jobs changes.
+    */
+    struct LevelStats
+    {
+        uint64_t enqueues = 0;      // Jobs added to its runnables (new, requeued, demoted into it, unblocked or preempted)
+        uint64_t demotions = 0;     // Jobs moved down out of it
+        uint64_t boosts = 0;        // Jobs lifted out of it to queue 0 by an epoch
+        uint64_t ranTicks = 0;      // Interrupts taken by jobs running at this level
+        uint64_t residentTicks = 0; // Ticks summed over every job at this level, running, runnable or blocked
+        uint64_t jobs = 0;          // Jobs at this level now
+        uint64_t runnable = 0;      // Depth of its runnables now
+        uint64_t lastChange = 0;    // Tick residentTicks was brought up to
+        uint64_t depthTotal = 0;    // Depth sampled on every enqueue
+        uint64_t depthMax = 0;
+    };
 
+    /*
+        One job changing level, in the order they are noticed (an epoch's boosts are noticed the next time the job is looked at)
+        from is -1 for a new job and to is -1 for a finished one
+    */
+    struct Transition
+    {
+        uint64_t tick;
+        uint64_t job;
+        int32_t from;
+        int32_t to;
+    };
 
     // Methods
-    OPCODE ParseCode(const std::string& code);
-    void CreateNewJob(const std::string& name = "");
-    void ScheduleNextJob();
+    void CreateNewJob(std::string_view name);
+    void ScheduleNextJob(const uint32_t& cpuIndex);
+    void WakeIdleCpus();
+    uint32_t BusiestCpu() const;
+    uint32_t LevelOf(Job* job);
+    void MakeRunnable(Job* job, const bool& atFront);
+    bool FindCpu(std::string_view text, uint32_t& cpuIndex);
 
     void HandleEpoch();
-    void FinishJob();
-    void Interrupt();
-    void Block();
-    void UnBlock(const std::string& name);
+    void FinishJob(const uint32_t& cpuIndex);
+    void Interrupt(const uint32_t& cpuIndex);
+    void Block(const uint32_t& cpuIndex);
+    void UnBlock(std::string_view name);
     void PrintRunnables();
     void PrintRunningTask();
     void PrintBlockedTasks();
+    void PrintJob(Job* job);
+    void StartRunning(Job* job);
+    void JoinLevel(const uint32_t& level);
+    void LeaveLevel(const uint32_t& level);
+    void SettleResidency(LevelStats& level);
+    FILE* OpenCsv(const std::string& filePath);
+    bool CloseCsv(FILE* fout);
+    static void WriteCsvField(FILE* fout, std::string_view text);
+    void RecordTransition(const Job* job, const uint64_t& tick, const int32_t& from, const int32_t& to);
+
+    // Per event output, dropped entirely when not verbose
+    template <typename... Args>
+    void Report(const Args&... args)
+    {
+        if (verbose)
+        {
+            out.Write(args...);
+        }
+    }
+
+    // Per event output about one CPU, which is named when there is more than one
+    template <typename... Args>
+    void ReportOn(const uint32_t& cpuIndex, const Args&... args)
+    {
+        if (verbose)
+        {
+            if (cpuCount > 1)
+            {
+                out.Write("CPU ", cpuIndex, ": ");
+            }
+            out.Write(args...);
+        }
+    }
 
     // Data Members
-    std::vector<FeedbackQueue*> allQueues;
-    Job* currRunningJob;
-    bool systemRunning;
-};
\ No newline at end of file
+    ObjectPool<Job> jobPool; // Every Job record, recycled as jobs finish
+    std::unique_ptr<Cpu[]> cpus;
+    uint32_t cpuCount;
+    uint32_t levelCount;
+    std::unordered_map<std::string_view, Job*> jobIndex; // Every job in the system by name, keys view the job's own name
+    uint64_t epochGeneration; // Bumped by every epoch, a job last placed in an older one is back in queue 0
+    bool verbose;
+    SchedulerStats stats;
+    JobLatencies latencies;
+    std::unique_ptr<LevelStats[]> levelStats;
+    bool recordTransitions;
+    std::vector<Transition> transitions;
+    std::vector<std::string> jobNames;  // By job id, kept only while transitions are recorded
+    std::vector<uint64_t> epochTicks;   // The tick of each epoch while transitions are recorded, to date the boosts only noticed later
+    OutputSink out;
+};
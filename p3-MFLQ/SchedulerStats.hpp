@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include "OutputSink.hpp"
+
+/*
+    Aggregate counts kept by both policies (MLFQSch & CFSSch)
+    and reported by their PrintSummary in summary (--quiet) mode
+    A count a policy has no use for stays 0: CFS never steals, MLFQ never preempts on a wakeup.
+*/
+struct SchedulerStats
+{
+    SchedulerStats() : instructions(0), newJobs(0), completed(0), schedules(0), interrupts(0),
+        blocks(0), unblocks(0), preemptions(0), epochs(0), steals(0), idles(0), errors(0) {}
+
+    uint64_t instructions;
+    uint64_t newJobs;
+    uint64_t completed;
+    uint64_t schedules;
+    uint64_t interrupts;
+    uint64_t blocks;
+    uint64_t unblocks;
+    uint64_t preemptions;
+    uint64_t epochs;
+    uint64_t steals;
+    uint64_t idles;
+    uint64_t errors;
+
+    /*
+        Print the totals along with what was left in the system at the end
+    */
+    void Print(OutputSink& out, const size_t& runnable, const size_t& running, const size_t& blocked) const
+    {
+        out.Write("Summary:\n");
+        out.Write(Column("Instructions:", 16), instructions, '\n');
+        out.Write(Column("New jobs:", 16), newJobs, '\n');
+        out.Write(Column("Completed:", 16), completed, '\n');
+        out.Write(Column("Scheduled:", 16), schedules, '\n');
+        out.Write(Column("Interrupts:", 16), interrupts, '\n');
+        out.Write(Column("Blocks:", 16), blocks, '\n');
+        out.Write(Column("Unblocks:", 16), unblocks, '\n');
+        out.Write(Column("Preemptions:", 16), preemptions, '\n');
+        out.Write(Column("Epochs:", 16), epochs, '\n');
+        out.Write(Column("Steals:", 16), steals, '\n');
+        out.Write(Column("Went idle:", 16), idles, '\n');
+        out.Write(Column("Errors:", 16), errors, '\n');
+        out.Write(Column("Still runnable:", 16), runnable, '\n');
+        out.Write(Column("Still running:", 16), running, '\n');
+        out.Write(Column("Still blocked:", 16), blocked, '\n');
+    }
+};
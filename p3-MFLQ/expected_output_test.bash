@@ -9,6 +9,7 @@
 # -i foo
 #		foo.input will be the input file
 #		foo.output will be the expected output file
+#		foo.args.txt, if there is one, holds options to run the program with (i.e. "-p wfq")
 
 temp_file="_tmp.txt"
 root=""
@@ -45,12 +46,22 @@ fi
 
 input_file="tests/"$root".input.txt"
 expected_output="tests/"$root".expected_output.txt"
+args_file="tests/"$root".args.txt"
+args=""
+if [ -f $args_file ]
+then
+	args=$(cat $args_file)
+fi
 
 echo "Test input file:      " $input_file
 echo "Expected output file: " $expected_output
+if [ -n "$args" ]
+then
+	echo "Options:              " $args
+fi
 echo "Expected output (must match letter for letter):"
 cat $expected_output
-$prog $input_file > $temp_file
+$prog $args $input_file > $temp_file
 echo "Your output:"
 cat $temp_file
 echo "Differences:"
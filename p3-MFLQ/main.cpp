@@ -3,21 +3,284 @@
 		NO PARTNER USED
 */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
 #include "MLFQSch.hpp"
+#include "CFSSch.hpp"
+#include "JobSimulator.hpp"
 
 using namespace std;
 
-int main(int argc, char * argv[]) {
-	MLFQSch sch;
-	if(argc > 1){
+enum POLICY {MLFQ, CFS};
+
+struct Options
+{
+	POLICY policy = MLFQ;
+	bool summaryOnly = false;
+	bool latency = false;		// Print response / turnaround / longest wait percentiles at exit
+	MLFQConfig config;
+	bool configGiven = false;	// -n, -t, -a or -c was given, all of which shape the MLFQ queues & CPUs
+	bool simulate = false;		// Jobs come from burst distributions rather than a trace
+	SimulationOptions simulation;
+	string levelCsvPath;		// Empty for no CSV
+	string transitionCsvPath;
+};
+
+void HandleOptions(int argc, char* argv[], Options& opts);
+void WriteCsvFiles(MLFQSch& sch, const Options& opts);
+void PrintUsage();
+
+/*
+	Every policy is driven the same way, whichever one was picked
+*/
+template <typename Policy>
+void RunTrace(Policy& sch, const Options& opts, int argc, char* argv[])
+{
+	sch.SetVerbose(!opts.summaryOnly);
+	if(optind < argc){
 		// Filename included
-		string filePath = string(argv[1]);
+		string filePath = string(argv[optind]);
 		sch.RunInstructionFile(filePath);
 	}
 	else
 	{
 		fprintf(stderr, "Missing input file name.\n");
+		PrintUsage();
 		exit(1);
 	}
+	if(opts.summaryOnly){
+		sch.PrintSummary();
+	}
+	if(opts.latency){
+		sch.PrintLatency();
+	}
+}
+
+int main(int argc, char * argv[]) {
+	Options opts;
+	HandleOptions(argc, argv, opts);
+
+	if(opts.policy == CFS){
+		if(opts.simulate || opts.configGiven || opts.levelCsvPath.size() > 0 || opts.transitionCsvPath.size() > 0){
+			fprintf(stderr, "Simulation, level statistics, queue & CPU options are only available for the mlfq policy\n");
+			exit(1);
+		}
+		CFSSch sch;
+		RunTrace(sch, opts, argc, argv);
+		return 0;
+	}
+
+	MLFQSch sch(opts.config);
+	sch.RecordTransitions(opts.transitionCsvPath.size() > 0);
+	if(opts.simulate){
+		sch.SetVerbose(!opts.summaryOnly);
+		JobSimulator simulator(opts.simulation, sch);
+		simulator.Run();
+		if(opts.summaryOnly){
+			sch.PrintSummary();
+		}
+		simulator.PrintResults();
+	}
+	else{
+		RunTrace(sch, opts, argc, argv);
+	}
+	WriteCsvFiles(sch, opts);
 	return 0;
 }
+//--
+/*
+	Write the per level counters & the per job level changes, for the files asked for
+*/
+void WriteCsvFiles(MLFQSch& sch, const Options& opts)
+{
+	if(opts.levelCsvPath.size() > 0 && !sch.WriteLevelCsv(opts.levelCsvPath)){
+		fprintf(stderr, "Level CSV could not be written: %s\n", opts.levelCsvPath.c_str());
+	}
+	if(opts.transitionCsvPath.size() > 0 && !sch.WriteTransitionCsv(opts.transitionCsvPath)){
+		fprintf(stderr, "Transition CSV could not be written: %s\n", opts.transitionCsvPath.c_str());
+	}
+}
+//--
+/*
+	Read in the command line options
+	-p / --policy NAME				mlfq (default) or cfs, a completely fair scheduler for comparison
+	-q / --quiet, -s / --summary	suppress the per event lines, print only the summary at the end
+	-l / --latency					print response / turnaround / longest wait percentiles at the end
+	-n / --queues N					number of feedback queues, 1 to 64 (default 4)
+	-t / --quanta Q0,Q1,...			interrupts a job runs for per turn, per queue (default 1)
+	-a / --allotments A0,A1,...		interrupts a job may use in a queue before moving down, per queue (default 1)
+									(a queue without a value of its own repeats the last one given)
+	-c / --cpus N					number of CPUs, each with its own queues (default 1)
+	-S / --simulate N				no trace: simulate N jobs drawn from the profiles below, and report their latencies
+	-P / --profile NAME:WEIGHT:CPU:IO:BURSTS	add a job profile (repeatable), see JobSimulator.hpp
+	-w / --arrival MEAN				mean ticks between job arrivals when simulating (default 64)
+	-e / --epoch T					ticks between epochs when simulating, 0 for none (default 100)
+	-r / --seed N					seed for the simulation's random draws (default 1)
+	-L / --level-csv FILE			write each level's counters to FILE as CSV at exit, - for standard output
+	-T / --transition-csv FILE		write every job's level changes to FILE as CSV at exit, - for standard output
+*/
+void HandleOptions(int argc, char* argv[], Options& opts)
+{
+	static const struct option longOptions[] = {
+		{"policy",	required_argument,	nullptr, 'p'},
+		{"latency",	no_argument,		nullptr, 'l'},
+		{"quiet",	no_argument,		nullptr, 'q'},
+		{"summary",	no_argument,		nullptr, 's'},
+		{"queues",	required_argument,	nullptr, 'n'},
+		{"quanta",	required_argument,	nullptr, 't'},
+		{"allotments",	required_argument,	nullptr, 'a'},
+		{"cpus",	required_argument,	nullptr, 'c'},
+		{"simulate",	required_argument,	nullptr, 'S'},
+		{"profile",	required_argument,	nullptr, 'P'},
+		{"arrival",	required_argument,	nullptr, 'w'},
+		{"epoch",	required_argument,	nullptr, 'e'},
+		{"seed",	required_argument,	nullptr, 'r'},
+		{"level-csv",	required_argument,	nullptr, 'L'},
+		{"transition-csv",	required_argument,	nullptr, 'T'},
+		{nullptr,	0,					nullptr, 0}
+	};
+
+	int c;
+	while ((c = getopt_long(argc, argv, "p:lqsn:t:a:c:S:P:w:e:r:L:T:", longOptions, nullptr)) != -1)
+	{
+		switch(c)
+		{
+			case 'p':
+			{
+				if(strcmp(optarg, "mlfq") == 0){
+					opts.policy = MLFQ;
+				}
+				else if(strcmp(optarg, "cfs") == 0){
+					opts.policy = CFS;
+				}
+				else{
+					fprintf(stderr, "Unknown policy: %s\n", optarg);
+					PrintUsage();
+					exit(1);
+				}
+				break;
+			}
+			case 'l':
+			{
+				opts.latency = true;
+				break;
+			}
+			case 'q':
+			case 's':
+			{
+				opts.summaryOnly = true;
+				break;
+			}
+			case 'n':
+			{
+				opts.configGiven = true;
+				unsigned long levels = strtoul(optarg, nullptr, 10);
+				if(levels < 1 || levels > MAX_NUMBER_OF_QUEUES){
+					fprintf(stderr, "The number of queues must be from 1 to %d\n", MAX_NUMBER_OF_QUEUES);
+					exit(1);
+				}
+				opts.config.levels = uint32_t(levels);
+				break;
+			}
+			case 't':
+			{
+				opts.configGiven = true;
+				if(!ReadCountList(optarg, opts.config.quanta)){
+					fprintf(stderr, "Quanta must be a comma separated list of counts of at least 1: %s\n", optarg);
+					exit(1);
+				}
+				break;
+			}
+			case 'a':
+			{
+				opts.configGiven = true;
+				if(!ReadCountList(optarg, opts.config.allotments)){
+					fprintf(stderr, "Allotments must be a comma separated list of counts of at least 1: %s\n", optarg);
+					exit(1);
+				}
+				break;
+			}
+			case 'c':
+			{
+				opts.configGiven = true;
+				unsigned long cpus = strtoul(optarg, nullptr, 10);
+				if(cpus < 1 || cpus > MAX_NUMBER_OF_CPUS){
+					fprintf(stderr, "The number of CPUs must be from 1 to %d\n", MAX_NUMBER_OF_CPUS);
+					exit(1);
+				}
+				opts.config.cpus = uint32_t(cpus);
+				break;
+			}
+			case 'S':
+			{
+				opts.simulate = true;
+				opts.simulation.jobs = strtoull(optarg, nullptr, 10);
+				break;
+			}
+			case 'P':
+			{
+				if(!ParseJobProfile(string(optarg), opts.simulation)){
+					fprintf(stderr, "A profile is NAME:WEIGHT:CPU:IO:BURSTS, weight above 0 and means of at least 1: %s\n", optarg);
+					exit(1);
+				}
+				break;
+			}
+			case 'w':
+			{
+				opts.simulation.meanArrival = atof(optarg);
+				break;
+			}
+			case 'e':
+			{
+				opts.simulation.epochInterval = strtoull(optarg, nullptr, 10);
+				break;
+			}
+			case 'r':
+			{
+				opts.simulation.seed = strtoull(optarg, nullptr, 10);
+				break;
+			}
+			case 'L':
+			{
+				opts.levelCsvPath = string(optarg);
+				break;
+			}
+			case 'T':
+			{
+				opts.transitionCsvPath = string(optarg);
+				break;
+			}
+			default:
+			{
+				PrintUsage();
+				exit(1);
+			}
+		}
+	}
+}
+//--
+void PrintUsage()
+{
+	fprintf(stderr, "Usage: a.out [options] instruction_file\n");
+	fprintf(stderr, "       a.out [options] -S JOBS [simulation options]\n");
+	fprintf(stderr, "-p, --policy NAME	(OPT)	mlfq (default) or cfs, completely fair scheduling for comparison\n");
+	fprintf(stderr, "			 	(the options below about queues, simulation & levels are mlfq only)\n");
+	fprintf(stderr, "-q, --quiet		(OPT)	print only summary statistics, no per event lines\n");
+	fprintf(stderr, "-l, --latency		(OPT)	print response, turnaround & longest wait percentiles at the end\n");
+	fprintf(stderr, "-s, --summary		(OPT)	same as --quiet\n");
+	fprintf(stderr, "-n, --queues N		(OPT)	number of feedback queues, 1 to %d (default %d)\n", MAX_NUMBER_OF_QUEUES, DEFAULT_NUMBER_OF_QUEUES);
+	fprintf(stderr, "-t, --quanta LIST	(OPT)	interrupts per turn in each queue, i.e. 1,2,4 (default 1)\n");
+	fprintf(stderr, "-a, --allotments LIST	(OPT)	interrupts a job may use in each queue before moving down (default 1)\n");
+	fprintf(stderr, "			 	a queue without a value repeats the last one in its list\n");
+	fprintf(stderr, "-c, --cpus N		(OPT)	number of CPUs, each with its own queues (default 1)\n");
+	fprintf(stderr, "-S, --simulate N	(OPT)	simulate N jobs from burst profiles instead of reading a trace\n");
+	fprintf(stderr, "-P, --profile SPEC	(OPT)	NAME:WEIGHT:CPU:IO:BURSTS job profile, repeatable\n");
+	fprintf(stderr, "			 	(default interactive:3:2:20:10 and batch:1:50:2:3)\n");
+	fprintf(stderr, "-w, --arrival MEAN	(OPT)	mean ticks between arrivals when simulating (default 64)\n");
+	fprintf(stderr, "-e, --epoch T		(OPT)	ticks between epochs when simulating, 0 for none (default 100)\n");
+	fprintf(stderr, "-r, --seed N		(OPT)	seed for the simulation (default 1)\n");
+	fprintf(stderr, "-L, --level-csv FILE	(OPT)	write each level's counters to FILE as CSV at exit, - for stdout\n");
+	fprintf(stderr, "-T, --transition-csv FILE (OPT)	write every job's level changes to FILE as CSV at exit, - for stdout\n");
+}
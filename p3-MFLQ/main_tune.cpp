@@ -0,0 +1,282 @@
+/*
+	Parallel parameter sweep for the MLFQ scheduler (make tune)
+
+	The trace is parsed once into an array of commands that every run shares read only,
+	then every combination of queue count, epoch interval & per level quanta in the grid
+	is run through its own quiet MLFQSch, on a pool of worker threads.
+	For each one the response time, turnaround & starvation (longest wait while runnable) of its jobs are reported,
+	measured in ticks, i.e. interrupts.
+
+	An epoch interval of N drops the trace's own epochs and has one every N ticks instead,
+	0 keeps the trace's epochs as they are.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MLFQSch.hpp"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+struct TuneOptions
+{
+	vector<uint32_t> queueCounts = {2, 3, 4, 8};
+	vector<uint32_t> epochIntervals = {0, 50, 100, 200, 500, 1000};
+	vector<vector<uint32_t>> quantaSets;	// Default: 1 everywhere, and 1,2,4,8
+	vector<uint32_t> allotments;			// Default: each level's quantum, one full turn per queue
+	uint32_t cpus = 1;
+	unsigned threads = 0;					// Default: one per core
+};
+
+/*
+	One point of the grid & how its jobs fared
+*/
+struct TuneRun
+{
+	MLFQConfig config;
+	uint32_t epochInterval = 0;
+	string quantaText;
+	uint64_t completed = 0;
+	uint64_t left = 0;				// Jobs still in the system at the end of the trace
+	uint64_t responseP50 = 0;
+	uint64_t responseP99 = 0;
+	uint64_t turnaroundP50 = 0;
+	uint64_t turnaroundP99 = 0;
+	uint64_t waitP99 = 0;
+	uint64_t waitMax = 0;			// Including jobs still waiting when the trace ends
+};
+
+void HandleOptions(int argc, char* argv[], TuneOptions& opts);
+string ListText(const vector<uint32_t>& values);
+void RunConfiguration(const vector<TraceCommand>& commands, TuneRun& run);
+void PrintUsage();
+
+
+int main(int argc, char * argv[]) {
+	TuneOptions opts;
+	HandleOptions(argc, argv, opts);
+	if(optind >= argc){
+		fprintf(stderr, "Missing input file name.\n");
+		PrintUsage();
+		exit(1);
+	}
+	if(opts.quantaSets.size() == 0){
+		opts.quantaSets.push_back({1});
+		opts.quantaSets.push_back({1, 2, 4, 8});
+	}
+
+	// Parse the trace once, every run reads the same commands (which view the mapped file)
+	TraceReader trace;
+	if(!trace.Open(argv[optind])){
+		fprintf(stderr, "Input file failed to open.\n");
+		exit(1);
+	}
+	vector<TraceCommand> commands;
+	TraceCommand cmd;
+	while(trace.Next(cmd)){
+		commands.push_back(cmd);
+	}
+
+	vector<TuneRun> runs;
+	for(uint32_t levels : opts.queueCounts){
+		for(const vector<uint32_t>& quanta : opts.quantaSets){
+			for(uint32_t epochInterval : opts.epochIntervals){
+				TuneRun run;
+				run.config.levels = levels;
+				run.config.cpus = opts.cpus;
+				run.config.quanta = quanta;
+				run.config.allotments = (opts.allotments.size() > 0) ? opts.allotments : quanta;
+				run.epochInterval = epochInterval;
+				run.quantaText = ListText(quanta);
+				runs.push_back(run);
+			}
+		}
+	}
+
+	unsigned threads = (opts.threads > 0) ? opts.threads : max(1u, thread::hardware_concurrency());
+	Clock::time_point start = Clock::now();
+	atomic<size_t> next(0);
+	vector<thread> workers;
+	for(unsigned t = 0; t < threads; t++){
+		workers.emplace_back([&commands, &runs, &next](){
+			for(size_t i = next++; i < runs.size(); i = next++){
+				RunConfiguration(commands, runs[i]);
+			}
+		});
+	}
+	for(thread& worker : workers){
+		worker.join();
+	}
+	double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+	OutputSink out;
+	out.Write(Column("QUEUES", 8), Column("EPOCH", 8), Column("QUANTA", 20), Column("DONE", 9), Column("LEFT", 7),
+			  Column("RESP P50", 10), Column("RESP P99", 10), Column("TURN P50", 10), Column("TURN P99", 10),
+			  Column("WAIT P99", 10), "WAIT MAX\n");
+	size_t fairest = 0;
+	for(size_t i = 0; i < runs.size(); i++){
+		const TuneRun& run = runs[i];
+		out.Write(Column(run.config.levels, 8));
+		if(run.epochInterval > 0){
+			out.Write(Column(run.epochInterval, 8));
+		}
+		else{
+			out.Write(Column("trace", 8));
+		}
+		out.Write(Column(run.quantaText, 20), Column(run.completed, 9), Column(run.left, 7),
+				  Column(run.responseP50, 10), Column(run.responseP99, 10), Column(run.turnaroundP50, 10),
+				  Column(run.turnaroundP99, 10), Column(run.waitP99, 10), run.waitMax, '\n');
+		fairest = (run.waitMax < runs[fairest].waitMax) ? i : fairest;
+	}
+	out.Write("Least starvation: ", runs[fairest].config.levels, " queues, quanta ", runs[fairest].quantaText, ", epoch ");
+	if(runs[fairest].epochInterval > 0){
+		out.Write("every ", runs[fairest].epochInterval, " ticks\n");
+	}
+	else{
+		out.Write("as in the trace\n");
+	}
+	out.Flush();
+	fprintf(stderr, "%zu configurations of %zu instructions in %.3f s (%u threads)\n", runs.size(), commands.size(), seconds, threads);
+	return 0;
+}
+//--
+/*
+	Run the whole trace through a scheduler of its own, with the epochs the run asks for
+	The commands are only read, so any number of runs can share them
+*/
+void RunConfiguration(const vector<TraceCommand>& commands, TuneRun& run)
+{
+	MLFQSch sch(run.config);
+	sch.SetVerbose(false);
+	TraceCommand epoch;
+	epoch.opcode = EPOCH;
+	epoch.arg2 = -1;
+	for(const TraceCommand& cmd : commands){
+		if(run.epochInterval > 0 && cmd.opcode == EPOCH){
+			continue;
+		}
+		uint64_t ticks = sch.Ticks();
+		sch.RunCommand(cmd);
+		// Only an interrupt the scheduler took is a tick, one on an idle CPU is an error that moves no time
+		if(run.epochInterval > 0 && sch.Ticks() != ticks && sch.Ticks() % run.epochInterval == 0){
+			sch.RunCommand(epoch);
+		}
+	}
+
+	const JobLatencies& latencies = sch.Latencies();
+	run.completed = latencies.turnaround.Count();
+	run.left = sch.JobCount();
+	run.responseP50 = latencies.response.Percentile(0.5);
+	run.responseP99 = latencies.response.Percentile(0.99);
+	run.turnaroundP50 = latencies.turnaround.Percentile(0.5);
+	run.turnaroundP99 = latencies.turnaround.Percentile(0.99);
+	run.waitP99 = latencies.longestWait.Percentile(0.99);
+	uint64_t waiting = sch.LongestCurrentWait();
+	run.waitMax = (waiting > latencies.longestWait.Max()) ? waiting : latencies.longestWait.Max();
+}
+//--
+string ListText(const vector<uint32_t>& values)
+{
+	string text;
+	for(size_t i = 0; i < values.size(); i++){
+		text += (i > 0) ? "," + to_string(values[i]) : to_string(values[i]);
+	}
+	return text;
+}
+//--
+/*
+	Read in the command line options
+	-n LIST		queue counts to try, i.e. 2,3,4,8 (default)
+	-e LIST		epoch intervals to try in ticks, 0 for the trace's own epochs (default 0,50,100,200,500,1000)
+	-t LIST		quanta of each level to try, repeat for more sets (default 1, and 1,2,4,8)
+	-a LIST		allotments of each level for every run (default each level's quantum)
+	-c N		number of CPUs (default 1)
+	-j N		worker threads (default: one per core)
+*/
+void HandleOptions(int argc, char* argv[], TuneOptions& opts)
+{
+	int c;
+	while ((c = getopt(argc, argv, "n:e:t:a:c:j:")) != -1)
+	{
+		switch(c)
+		{
+			case 'n':
+			{
+				if(!ReadCountList(optarg, opts.queueCounts, 1)){
+					fprintf(stderr, "Queue counts must be a comma separated list of counts of at least 1: %s\n", optarg);
+					exit(1);
+				}
+				for(uint32_t levels : opts.queueCounts){
+					if(levels > MAX_NUMBER_OF_QUEUES){
+						fprintf(stderr, "The number of queues must be from 1 to %d\n", MAX_NUMBER_OF_QUEUES);
+						exit(1);
+					}
+				}
+				break;
+			}
+			case 'e':
+			{
+				if(!ReadCountList(optarg, opts.epochIntervals, 0)){
+					fprintf(stderr, "Epoch intervals must be a comma separated list of tick counts: %s\n", optarg);
+					exit(1);
+				}
+				break;
+			}
+			case 't':
+			{
+				vector<uint32_t> quanta;
+				if(!ReadCountList(optarg, quanta, 1)){
+					fprintf(stderr, "Quanta must be a comma separated list of counts of at least 1: %s\n", optarg);
+					exit(1);
+				}
+				opts.quantaSets.push_back(quanta);
+				break;
+			}
+			case 'a':
+			{
+				if(!ReadCountList(optarg, opts.allotments, 1)){
+					fprintf(stderr, "Allotments must be a comma separated list of counts of at least 1: %s\n", optarg);
+					exit(1);
+				}
+				break;
+			}
+			case 'c':
+			{
+				unsigned long cpus = strtoul(optarg, nullptr, 10);
+				if(cpus < 1 || cpus > MAX_NUMBER_OF_CPUS){
+					fprintf(stderr, "The number of CPUs must be from 1 to %d\n", MAX_NUMBER_OF_CPUS);
+					exit(1);
+				}
+				opts.cpus = uint32_t(cpus);
+				break;
+			}
+			case 'j':
+			{
+				opts.threads = max(1u, unsigned(strtoul(optarg, nullptr, 10)));
+				break;
+			}
+			default:
+			{
+				PrintUsage();
+				exit(1);
+			}
+		}
+	}
+}
+//--
+void PrintUsage()
+{
+	fprintf(stderr, "Usage: tune [options] instruction_file\n");
+	fprintf(stderr, "-n LIST	(OPT)	queue counts to try (default 2,3,4,8)\n");
+	fprintf(stderr, "-e LIST	(OPT)	epoch intervals to try in ticks, 0 keeps the trace's epochs (default 0,50,100,200,500,1000)\n");
+	fprintf(stderr, "-t LIST	(OPT)	quanta per level to try, repeatable (default 1, and 1,2,4,8)\n");
+	fprintf(stderr, "-a LIST	(OPT)	allotments per level for every run (default each level's quantum)\n");
+	fprintf(stderr, "-c N	(OPT)	number of CPUs (default 1)\n");
+	fprintf(stderr, "-j N	(OPT)	worker threads (default one per core)\n");
+}